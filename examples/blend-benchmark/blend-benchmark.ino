@@ -0,0 +1,123 @@
+#include "GU_Elements.h"
+
+// Throughput of the RGB565 blending functions, printed to Serial.
+
+// Uses libraries:
+// GU_Elements for the blending functions and frame buffer access
+// Arduino_GigaDisplay_GFX for screen display
+// (and all their dependencies)
+
+GigaDisplay_GFX tft;
+
+// Spans are the size of the screen, and held in SDRAM as pixel buffers are.
+#define N_PIXELS  (800 * 480)
+#define REPEATS   10
+
+uint16_t *dst, *src;
+
+// The way colors were averaged before the span functions, for comparison.
+void unpack_average_span(uint16_t *dst, const uint16_t *src, int n)
+{
+  uint8_t r1, g1, b1, r2, g2, b2;
+
+  for (int i = 0; i < n; i++)
+  {
+    rgb565_unpack(dst[i], &r1, &g1, &b1);
+    rgb565_unpack(src[i], &r2, &g2, &b2);
+    dst[i] = rgb565_pack((r1 + r2) / 2, (g1 + g2) / 2, (b1 + b2) / 2);
+  }
+}
+
+// Print the rate in millions of pixels per second, given the time taken
+// for REPEATS spans.
+void report(char *name, unsigned long us)
+{
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print((float)N_PIXELS * REPEATS / us);
+  Serial.println(" Mpixels/s");
+}
+
+void fill(void)
+{
+  for (int i = 0; i < N_PIXELS; i++)
+  {
+    dst[i] = random(0x10000);
+    src[i] = random(0x10000);
+  }
+}
+
+void setup()
+{
+  unsigned long start;
+
+  Serial.begin(9600);
+  while(!Serial) {}
+
+  tft.begin();
+  tft.setRotation(1);
+
+  dst = GU_FrameBuffer::allocPixels(N_PIXELS);
+  src = GU_FrameBuffer::allocPixels(N_PIXELS);
+  if (dst == NULL || src == NULL)
+  {
+    Serial.println("Can't allocate pixel buffers");
+    while(1) ;
+  }
+  fill();
+
+  start = micros();
+  for (int k = 0; k < REPEATS; k++)
+    unpack_average_span(dst, src, N_PIXELS);
+  report("average (unpack and pack)", micros() - start);
+
+  start = micros();
+  for (int k = 0; k < REPEATS; k++)
+    rgb565_average_span(dst, src, N_PIXELS);
+  report("average", micros() - start);
+
+  // Spans starting on odd pixels of both, and of only one.
+  start = micros();
+  for (int k = 0; k < REPEATS; k++)
+    rgb565_average_span(dst + 1, src + 1, N_PIXELS - 1);
+  report("average (both odd)", micros() - start);
+
+  start = micros();
+  for (int k = 0; k < REPEATS; k++)
+    rgb565_average_span(dst + 1, src, N_PIXELS - 1);
+  report("average (one odd)", micros() - start);
+
+  start = micros();
+  for (int k = 0; k < REPEATS; k++)
+    rgb565_blend_span(dst, src, N_PIXELS, 12);
+  report("blend", micros() - start);
+
+  start = micros();
+  for (int k = 0; k < REPEATS; k++)
+    rgb565_mix_span(dst, N_PIXELS, BLUE, 12);
+  report("mix", micros() - start);
+
+  start = micros();
+  for (int k = 0; k < REPEATS; k++)
+    rgb565_darken_span(dst, N_PIXELS, 12);
+  report("darken", micros() - start);
+
+  start = micros();
+  for (int k = 0; k < REPEATS; k++)
+    rgb565_darken_span(dst, N_PIXELS, 16);
+  report("darken by half", micros() - start);
+
+  // Darkening the screen itself, as behind a menu.
+  GU_FrameBuffer fb(&tft);
+
+  tft.fillScreen(WHITE);
+  start = micros();
+  for (int k = 0; k < REPEATS; k++)
+    fb.blendRect(0, 0, tft.width(), tft.height(), BLACK, 2);
+  report("blendRect on screen", micros() - start);
+}
+
+void loop() {
+
+  delay(10);
+}
@@ -42,6 +42,12 @@ void refresh(void)
   button2.drawButton();
 }
 
+// Clear the line that Log writes to.
+void clearLog(int y = 200)
+{
+  tft.fillRect(0, y - 40, tft.width(), 50, 0);
+}
+
 // callback is called when a button is pressed and released.
 void tap_cb(EventType ev, int indx, void *param, int x, int y)
 {
@@ -50,15 +56,28 @@ void tap_cb(EventType ev, int indx, void *param, int x, int y)
 
   refresh();
   if (ev & EV_LONG_PRESS)
+  {
+    // Long presses turn the button on and off. Changing its label and colors
+    // only invalidates it; it is drawn once, at the next frame.
+    static bool on = false;
+
+    on = !on;
+    button1.setText(on ? "On" : "Button");
+    button1.setColor(BLACK, on ? GREEN : YELLOW, BLACK);
     Log("Long pressed");
+  }
   else
+  {
     Log("Tapped");
+  }
 }
 
 // Callback is called whenever a menu item is selected.
+// The menu has put back what was under it, so there is no need to
+// refresh the whole screen; just clear the previous log message.
 void menu_cb(EventType ev, int indx, void *param, int x, int y)
 {
-  refresh();
+  clearLog();
   if ((indx & 0xFF) == 0xFF)
     Log("No selection made");
   else
@@ -102,6 +121,14 @@ void setup()
   // A help tip
   menu.setTip("Select something from the menu");
 
+  // Save and restore the screen under the menu, and dim the rest of
+  // the screen to half brightness while the menu is up
+  menu.setSaveUnder(true);
+  menu.setDimBehind(16);
+
+  // Draw changed buttons once per frame, rather than as they are changed.
+  GU_Frame::setDeferred(true);
+
   // Clear the screen and draw the buttons
   refresh();
 }
@@ -109,6 +136,7 @@ void setup()
 void loop() {
 
   detector.poll();
+  GU_Frame::tick();
 
   delay(10);
 }
\ No newline at end of file
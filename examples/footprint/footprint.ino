@@ -0,0 +1,41 @@
+#include "GU_Elements.h"
+
+// Prints the memory taken by buttons and menus of various sizes.
+// Buttons and menus hold their labels (and menus their items and tip)
+// inside themselves, so their sizes are fixed when they are declared.
+
+// Uses libraries:
+// GU_Elements for UI elements
+// (and all its dependencies)
+
+// Some menu sizes
+typedef GU_MenuT<4, 12, 1> SmallMenu;       // a few short items, no tip
+typedef GU_MenuT<8, 20, 40> MediumMenu;
+typedef GU_MenuT<20, 32, 80> LongLabelMenu;  // room for long item labels
+
+void report(char *name, size_t size)
+{
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(size);
+  Serial.println(" bytes");
+}
+
+void setup()
+{
+  Serial.begin(9600);
+  while(!Serial) {}
+
+  report("GU_Button (default)", sizeof(GU_Button));
+  report("GU_ButtonT<4>", sizeof(GU_ButtonT<4>));
+  report("GU_ButtonT<24>", sizeof(GU_ButtonT<24>));
+  report("GU_Menu (default)", sizeof(GU_Menu));
+  report("GU_MenuT<4, 12, 1>", sizeof(SmallMenu));
+  report("GU_MenuT<8, 20, 40>", sizeof(MediumMenu));
+  report("GU_MenuT<20, 32, 80>", sizeof(LongLabelMenu));
+}
+
+void loop() {
+
+  delay(10);
+}
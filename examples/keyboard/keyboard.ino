@@ -0,0 +1,70 @@
+#include "GU_Elements.h"
+
+// Example program for the on-screen keyboard. Type a name and press OK.
+
+// Uses libraries:
+// GestureDetector for screen interaction
+// GU_Elements for UI elements
+// Arduino_GigaDisplay_GFX for screen display
+// (and all their dependencies)
+
+// Construct the graphics and gesture libs
+GestureDetector detector;
+GigaDisplay_GFX tft;
+
+// Text and UI symbol fonts
+#include <fonts/FreeSans18pt7b.h>
+#include <fonts/UISymbolSans18pt7b.h>
+FontCollection fc(&tft, &FreeSans18pt7b, &UISymbolSans18pt7b, 1, 1);
+
+// The keyboard, taking the bottom of the screen
+GU_Keyboard keyboard(&fc, &detector);
+
+void Log(char *str, int x = 50, int y = 80)
+{
+  tft.fillRect(0, y - 40, tft.width(), 50, BLACK);
+  fc.drawText(str, x, y, WHITE);
+  Serial.println(str);
+}
+
+// Callback is called as each key is released.
+void key_cb(EventType ev, int indx, void *param, int x, int y)
+{
+  char buf[64];
+
+  if ((indx & 0xFF) == GU_KEY_ENTER)
+  {
+    sprintf(buf, "Hello, %s", keyboard.getText());
+    Log(buf);
+    keyboard.setText("");
+  }
+}
+
+void setup()
+{
+  Serial.begin(9600);
+  while(!Serial) {}
+
+  tft.begin();
+  if (detector.begin()) {
+    Serial.println("Touch controller init - OK");
+  } else {
+    Serial.println("Touch controller init - FAILED");
+    while(1) ;
+  }
+
+  // Set the rotation. These must occur together.
+  tft.setRotation(1);
+  detector.setRotation(1);
+  tft.fillScreen(BLACK);
+
+  Log("What's your name?");
+  keyboard.initKeyboard(0, 130, 800, 350, WHITE, DKGREY, GREY, WHITE, key_cb, 1);
+}
+
+void loop() {
+
+  detector.poll();
+
+  delay(10);
+}
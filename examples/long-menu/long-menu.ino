@@ -27,6 +27,11 @@ GU_Menu menu(&fc, &detector);
 char *items[10] = { "An item", "Another item", "A long item name",
                   "Item 3", "Item 4", "Item 5", "Item 6", "Item 7", "Item 8", "Item 9" };
 
+// A gesture trace of the menu being used, recorded and replayed by typing
+// r (record), s (stop) and p (play back) in the serial monitor.
+uint8_t trace[4096];
+uint32_t trace_len = 0;
+
 void Log(char *str, int x = 50, int y = 200)
 {
   fc.drawText(str, x, y, WHITE);
@@ -76,16 +81,14 @@ void setup()
   // Set up the menu and its items.
   menu.initMenu(&button2, WHITE, DKGREY, GREY, WHITE, menu_cb, 3, NULL);
   //menu.initMenu(&button2, WHITE, WHITE, GREY, BLACK, menu_cb, 3, NULL);   // black text on white
+  // Set the items together, so the menu is laid out once at the commit.
+  menu.beginMenuItems();
   menu.setMenuItem(0, items[0]);
   menu.setMenuItem(1, items[1], false);  // Disable this item
   menu.setMenuItem(2, items[2], true, true, true);  // Check mark and underline this item
-  menu.setMenuItem(3, items[3]);
-  menu.setMenuItem(4, items[4]);
-  menu.setMenuItem(5, items[5]);
-  menu.setMenuItem(6, items[6]);
-  menu.setMenuItem(7, items[7]);
-  menu.setMenuItem(8, items[8]);
-  menu.setMenuItem(9, items[9]);
+  for (int i = 3; i < 10; i++)
+    menu.setMenuItem(i, items[i]);
+  menu.commitMenuItems();
 
   // A help tip
   menu.setTip("This is a long (scrolling) menu");
@@ -94,9 +97,50 @@ void setup()
   refresh();
 }
 
+// Handle the trace commands. The trace is replayed from the screen as it was
+// when it was recorded (here, just the button), and printed out so it can be
+// kept as a test.
+void traceCommand(char c)
+{
+  GU_TraceResult result;
+
+  switch (c)
+  {
+  case 'r':
+    refresh();
+    GU_Trace::record(trace, sizeof(trace));
+    Serial.println("Recording");
+    break;
+  case 's':
+    trace_len = GU_Trace::stop();
+    GU_Trace::dump(&Serial, trace, trace_len);
+    break;
+  case 'p':
+    refresh();
+    GU_Trace::replay(trace, trace_len, &result);
+    Serial.print("Events ");
+    Serial.print(result.events);
+    Serial.print(" rejected ");
+    Serial.print(result.rejected);
+    Serial.print(" frames ");
+    Serial.print(result.frames);
+    Serial.print(" drawing ");
+    Serial.print(result.draw_us);
+    Serial.print("us (longest ");
+    Serial.print(result.max_us);
+    Serial.print("us) over ");
+    Serial.print(result.trace_ms);
+    Serial.println("ms");
+    break;
+  }
+}
+
 void loop() {
 
   detector.poll();
+  GU_Frame::tick();     // keeps a flicked menu scrolling
+  if (Serial.available())
+    traceCommand(Serial.read());
 
   delay(10);
 }
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "GU_Elements.h"
+
+// Example program for a pager whose pages' buttons and menus are held
+// in an arena. Each page's elements are made as the page is shown, and
+// all taken down together as it is left.
+
+// Uses libraries:
+// GestureDetector for screen interaction
+// GU_Elements for UI elements
+// Arduino_GigaDisplay_GFX for screen display
+// (and all their dependencies)
+
+// Construct the graphics and gesture libs
+GestureDetector detector;
+GigaDisplay_GFX tft;
+
+// Text and UI symbol fonts
+#include <fonts/FreeSans18pt7b.h>
+#include <fonts/UISymbolSans18pt7b.h>
+FontCollection fc(&tft, &FreeSans18pt7b, &UISymbolSans18pt7b, 1, 1);
+
+// Text size multiplier for buttons and menus
+const int tsize = 1;
+
+// The arena holding the buttons and menus of the page being shown.
+GU_Arena arena(&detector);
+char *items[3] = { "An item", "Another item", "A long item name" };
+
+// A pager with 3 pages.
+GU_Pager pager(&tft, &detector);
+
+void Log(char *str, int x = 50, int y = 200)
+{
+  fc.drawText(str, x, y, WHITE);
+  Serial.println(str);
+}
+
+// callback is called when a button is pressed and released.
+void tap_cb(EventType ev, int indx, void *param, int x, int y)
+{
+  char buf[32];
+
+  if ((ev & EV_RELEASED) == 0)
+    return;   // we only act on the releases
+
+  sprintf(buf, "Tapped button %d", indx);
+  Log(buf);
+}
+
+// Callback is called whenever a menu item is selected.
+void menu_cb(EventType ev, int indx, void *param, int x, int y)
+{
+  if ((indx & 0xFF) == 0xFF)
+    Log("No selection made");
+  else
+    Log(items[indx & 0xFF]);
+}
+
+// Pager show callback. The arena has already taken down the page being
+// left, so just build the page being shown.
+void pager_swipe_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
+{
+  int new_page = indx & 0xFF;
+  GU_Button *button;
+  GU_Menu *menu;
+  char label[8];
+
+  switch (new_page)
+  {
+  case 0:
+    // A button, and a button with a menu.
+    button = arena.newButton(&fc);
+    button->initButtonUL(240, 5, 150, 45, BLACK, YELLOW, BLACK, "Button", tsize, tap_cb, 2, NULL);
+    button->drawButton();
+
+    button = arena.newButton(&fc);
+    button->initButtonUL(480, 5, 150, 45, WHITE, DKGREY, WHITE, "Menu", tsize);
+    button->drawButton();
+    menu = arena.newMenu(&fc);
+    menu->initMenu(button, WHITE, DKGREY, GREY, WHITE, menu_cb, 3, NULL);
+    // The menu is built again each time the page is shown, so lay it out once.
+    menu->beginMenuItems();
+    menu->setMenuItem(0, items[0]);
+    menu->setMenuItem(1, items[1], false);  // Disable this item
+    menu->setMenuItem(2, items[2], true, true);  // Check mark this item
+    menu->commitMenuItems();
+    Log("Page 0", 50, 300);
+    break;
+  case 1:
+    // A grid of buttons.
+    for (int i = 0; i < 12; i++)
+    {
+      sprintf(label, "%d", i);
+      button = arena.newButton(&fc);
+      button->initButtonUL(40 + (i % 6) * 120, 40 + (i / 6) * 80, 100, 60,
+                           WHITE, DKGREY, WHITE, label, tsize, tap_cb, i, NULL);
+      button->drawButton();
+    }
+    Log("Page 1", 50, 300);
+    break;
+  case 2:
+    // Nothing on this page.
+    Log("Page 2", 50, 300);
+    break;
+  }
+}
+
+void setup()
+{
+  Serial.begin(9600);
+  while(!Serial) {}
+
+  tft.begin();
+  if (detector.begin()) {
+    Serial.println("Touch controller init - OK");
+  } else {
+    Serial.println("Touch controller init - FAILED");
+    while(1) ;
+  }
+
+  // Set the rotation. These must occur together.
+  tft.setRotation(1);
+  detector.setRotation(1);
+
+  // Route taps to the arena's elements from event 1, and reset it as
+  // pages are left.
+  arena.begin(1);
+  pager.setArena(&arena);
+
+  // Init the pager to show Page 0 of 3 pages.
+  pager.initPager(3, 0, pager_swipe_cb, NULL, BLACK);
+}
+
+void loop() {
+
+  detector.poll();
+
+  delay(10);
+}
@@ -29,20 +29,27 @@ GU_Menu menu(&fc, &detector);
 char *items[3] = { "An item", "Another item", "A long item name" };
 
 // A pager with 3 pages. The above buttons and menu are on Page 0.
+// Pages are kept in a cache, so swiping back to a page just copies it back.
 GU_Pager pager(&tft, &detector);
 
+// Fonts for drawing pages ahead of time, into the pager's off-screen GFX.
+FontCollection *render_fc;
+
 void Log(char *str, int x = 50, int y = 200)
 {
   fc.drawText(str, x, y, WHITE);
   Serial.println(str);
 }
 
-// Refresh the screen and redraw the buttons.
+// Refresh the screen and redraw the buttons. They are recorded in a display
+// list, so the parts of the screen under the buttons are not cleared first.
 void refresh(void)
 {
+  GU_DisplayList::begin(&tft);
   pager.clearPage(true);
   button1.drawButton();
   button2.drawButton();
+  GU_DisplayList::end();
 }
 
 // callback is called when a button is pressed and released.
@@ -68,6 +75,16 @@ void menu_cb(EventType ev, int indx, void *param, int x, int y)
     Log(items[indx & 0xFF]);
 }
 
+// Pager render callback. Draw the content of pages 1 and 2 off-screen,
+// so they can be shown as soon as they are swiped to.
+void pager_render_cb(int page, Adafruit_GFX *gfx, void *param)
+{
+  if (page == 1)
+    render_fc->drawText("Page 1", 50, 300, WHITE);
+  else if (page == 2)
+    render_fc->drawText("Page 2", 50, 300, WHITE);
+}
+
 // Pager show callback. Take down any UI on the page being left behind,
 // and redraw any on the page being shown.
 void pager_swipe_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
@@ -105,17 +122,22 @@ void pager_swipe_cb(EventType ev, int indx, void *param, int x, int y, int dx, i
     menu.setMenuItem(1, items[1], false);  // Disable this item
     menu.setMenuItem(2, items[2], true, true);  // Check mark this item
 
-    // Draw buttons
-    button1.drawButton();
-    button2.drawButton();
-    Log("Page 0", 50, 300);
+    // Draw buttons, unless the page has come back from the cache
+    if (!pager.isPageRestored())
+    {
+      button1.drawButton();
+      button2.drawButton();
+      Log("Page 0", 50, 300);
+    }
     break;
   case 1:
   // The other pages have nothing on them at present.
-    Log("Page 1", 50, 300);
+    if (!pager.isPageRestored())
+      Log("Page 1", 50, 300);
     break;
   case 2:
-    Log("Page 2", 50, 300);
+    if (!pager.isPageRestored())
+      Log("Page 2", 50, 300);
     break;
   }
 }
@@ -137,6 +159,11 @@ void setup()
   tft.setRotation(1);
   detector.setRotation(1);
 
+  // Cache all 3 pages (800 x 480 x 2 bytes each), and draw pages ahead
+  // of time with the render callback.
+  pager.enableCache(3 * 800 * 480 * 2, pager_render_cb);
+  render_fc = new FontCollection(pager.getRenderGFX(), &FreeSans18pt7b, &UISymbolSans18pt7b, 1, 1);
+
   // Init the pager to show Page 0 of 3 pages. The callback is responsible
   // for drawing the pages as they are shown and hidden by swiping.
   pager.initPager(3, 0, pager_swipe_cb, NULL, BLACK);
@@ -145,6 +172,7 @@ void setup()
 void loop() {
 
   detector.poll();
+  pager.idle();
 
   delay(10);
 }
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "GU_Elements.h"
+
+// Example program for the render queue. loop() takes in a (made up) signal
+// and posts it to a strip chart, a progress bar and a button's label. Every
+// so often it stalls for a while, as a slow acquisition step might, but
+// touches are still answered, as the drawing and touch handling are done
+// by the render thread.
+//
+// Every 5 seconds the number of changes posted and dropped is printed to
+// Serial. Set GU_LATENCY to 1 in GU_Elements.h to print the time from
+// posting a change to its being made as well.
+
+// Uses libraries:
+// GestureDetector for screen interaction
+// GU_Elements for UI elements
+// Arduino_GigaDisplay_GFX for screen display
+// (and all their dependencies)
+
+// Construct the graphics and gesture libs
+GestureDetector detector;
+GigaDisplay_GFX tft;
+
+// Text and UI symbol fonts
+#include <fonts/FreeSans18pt7b.h>
+#include <fonts/UISymbolSans18pt7b.h>
+FontCollection fc(&tft, &FreeSans18pt7b, &UISymbolSans18pt7b, 1, 1);
+
+GU_StripChart chart(&tft);
+GU_ProgressBar bar(&tft);
+GU_Button level(&fc, &detector);
+GU_Button button(&fc, &detector);
+
+// Samples are made up in blocks of 120 every 6ms (20kHz).
+#define BLOCK       120
+#define BLOCK_MS    6
+int16_t block[BLOCK];
+uint32_t n_samples = 0;
+unsigned long last_block = 0;
+unsigned long last_report = 0;
+int taps = 0;
+
+// The button is tapped on the render thread, so it can draw straight away.
+void tap_cb(EventType ev, int indx, void *param, int x, int y)
+{
+  char buf[16];
+
+  if ((ev & EV_RELEASED) == 0)
+    return;
+  sprintf(buf, "Taps %d", ++taps);
+  button.setText(buf);
+}
+
+void make_block(void)
+{
+  for (int i = 0; i < BLOCK; i++)
+  {
+    float t = n_samples++ / 20000.0;
+
+    block[i] = 600 * sin(t * 2 * PI * 0.5) + random(-40, 40);
+  }
+}
+
+void setup()
+{
+  Serial.begin(9600);
+  while(!Serial) {}
+
+  tft.begin();
+  if (detector.begin()) {
+    Serial.println("Touch controller init - OK");
+  } else {
+    Serial.println("Touch controller init - FAILED");
+    while(1) ;
+  }
+
+  // Set the rotation. These must occur together.
+  tft.setRotation(1);
+  detector.setRotation(1);
+  tft.fillScreen(BLACK);
+
+  // Set everything up before the render thread starts. From then on, only
+  // the thread draws.
+  GU_Frame::setDeferred(true);
+  chart.initChart(0, 100, 800, 250, BLACK, GREEN, -1000, 1000, 60);
+  bar.initBar(200, 380, 580, 40, WHITE, GREEN, BLACK, 0, 1000, 0);
+  level.initButtonUL(20, 380, 160, 40, WHITE, BLACK, WHITE, "", 1);
+  button.initButtonUL(20, 20, 200, 50, WHITE, DKGREY, WHITE, "Tap me", 1, tap_cb, 1);
+  if (!GU_RenderQueue::startThread(&detector))
+  {
+    Serial.println("Can't start the render thread");
+    while(1) ;
+  }
+}
+
+void loop() {
+
+  char buf[16];
+
+  if (millis() - last_block < BLOCK_MS)
+    return;
+  last_block += BLOCK_MS;
+
+  make_block();
+  GU_RenderQueue::addSamples(&chart, block, BLOCK);
+  GU_RenderQueue::setValue(&bar, abs(block[0]));
+  sprintf(buf, "%d", block[0]);
+  GU_RenderQueue::setText(&level, buf);
+
+  // Stall for half a second every 3 seconds, then catch up.
+  if (n_samples % 60000 < BLOCK)
+    delay(500);
+
+  if (millis() - last_report >= 5000)
+  {
+    last_report = millis();
+    Serial.print("Posted ");
+    Serial.print(GU_RenderQueue::numPosted());
+    Serial.print(" dropped ");
+    Serial.println(GU_RenderQueue::numDropped());
+    GU_Latency::dump(&Serial);
+  }
+}
@@ -0,0 +1,84 @@
+#include "GU_Elements.h"
+
+// Example program for sliders and progress bars. A progress bar follows a
+// value sampled at 200Hz, and a slider sets the level it is compared with.
+
+// Uses libraries:
+// GestureDetector for screen interaction
+// GU_Elements for UI elements
+// Arduino_GigaDisplay_GFX for screen display
+// (and all their dependencies)
+
+// Construct the graphics and gesture libs
+GestureDetector detector;
+GigaDisplay_GFX tft;
+
+// Text and UI symbol fonts
+#include <fonts/FreeSans18pt7b.h>
+#include <fonts/UISymbolSans18pt7b.h>
+FontCollection fc(&tft, &FreeSans18pt7b, &UISymbolSans18pt7b, 1, 1);
+
+// The level, and the value sampled
+GU_Slider slider(&tft, &detector);
+GU_ProgressBar bar(&tft);
+
+unsigned long last_sample = 0;
+
+void Log(char *str, int x = 50, int y = 80)
+{
+  tft.fillRect(0, y - 40, tft.width(), 50, BLACK);
+  fc.drawText(str, x, y, WHITE);
+}
+
+// Callback is called as the slider is dragged.
+void slider_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
+{
+  char buf[32];
+
+  if (ev & EV_RELEASED)
+  {
+    sprintf(buf, "Level %d", (int)slider.getValue());
+    Log(buf);
+  }
+}
+
+void setup()
+{
+  Serial.begin(9600);
+  while(!Serial) {}
+
+  tft.begin();
+  if (detector.begin()) {
+    Serial.println("Touch controller init - OK");
+  } else {
+    Serial.println("Touch controller init - FAILED");
+    while(1) ;
+  }
+
+  // Set the rotation. These must occur together.
+  tft.setRotation(1);
+  detector.setRotation(1);
+  tft.fillScreen(BLACK);
+
+  // Draw the bar at most 30 times a second, however often its value is set.
+  GU_Frame::setDeferred(true);
+
+  slider.initSlider(100, 150, 600, 60, WHITE, DKGREY, BLACK, WHITE, 0, 1000, 500, slider_cb, 1);
+  bar.initBar(100, 300, 600, 40, WHITE, GREEN, BLACK, 0, 1000, 0);
+  Log("Level 500");
+}
+
+void loop() {
+
+  detector.poll();
+
+  // Sample a (made up) signal every 5ms.
+  if (millis() - last_sample >= 5)
+  {
+    int32_t value = 500 + 450 * sin(millis() / 1000.0);
+
+    last_sample = millis();
+    bar.setValue(value);
+  }
+  GU_Frame::tick();
+}
@@ -0,0 +1,107 @@
+#include "GU_Elements.h"
+
+// Example program for strip charts. A (made up) signal sampled at 20kHz is
+// plotted on the first of two pages, 100 samples to a column. The chart keeps
+// taking samples while the other page is shown, and is drawn in full when
+// it is swiped back to.
+
+// Uses libraries:
+// GestureDetector for screen interaction
+// GU_Elements for UI elements
+// Arduino_GigaDisplay_GFX for screen display
+// (and all their dependencies)
+
+// Construct the graphics and gesture libs
+GestureDetector detector;
+GigaDisplay_GFX tft;
+
+// Text and UI symbol fonts
+#include <fonts/FreeSans18pt7b.h>
+#include <fonts/UISymbolSans18pt7b.h>
+FontCollection fc(&tft, &FreeSans18pt7b, &UISymbolSans18pt7b, 1, 1);
+
+GU_StripChart chart(&tft);
+GU_Pager pager(&tft, &detector);
+
+// Samples are made up in blocks, as they would come from a DMA buffer.
+#define SAMPLE_US   50
+#define BLOCK       256
+int16_t block[BLOCK];
+int n_block = 0;
+unsigned long next_sample = 0;
+uint32_t n_samples = 0;
+
+// A slow sine wave with a burst of a faster one every few seconds, and noise.
+int16_t make_sample(void)
+{
+  float t = n_samples++ * SAMPLE_US / 1000000.0;
+  float v = 600 * sin(t * 2 * PI * 0.5);
+
+  if ((int)t % 4 == 0)
+    v += 300 * sin(t * 2 * PI * 200);
+  return v + random(-40, 40);
+}
+
+// Pager callback. Hide the chart when its page is left, and draw it when
+// it's shown again.
+void pager_swipe_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
+{
+  int new_page = indx & 0xFF;
+
+  chart.hideChart();
+  if (new_page == 0)
+  {
+    fc.drawText("Strip chart", 50, 60, WHITE);
+    chart.drawChart();
+  }
+  else
+  {
+    fc.drawText("Page 1", 50, 60, WHITE);
+  }
+}
+
+void setup()
+{
+  Serial.begin(9600);
+  while(!Serial) {}
+
+  tft.begin();
+  if (detector.begin()) {
+    Serial.println("Touch controller init - OK");
+  } else {
+    Serial.println("Touch controller init - FAILED");
+    while(1) ;
+  }
+
+  // Set the rotation. These must occur together.
+  tft.setRotation(1);
+  detector.setRotation(1);
+
+  // Move the chart along at most 30 times a second, however many columns
+  // have come in.
+  GU_Frame::setDeferred(true);
+
+  // 100 samples to a column, so 200 columns a second, from -1000 to 1000.
+  chart.initChart(0, 100, 800, 300, BLACK, GREEN, -1000, 1000, 100);
+  pager.initPager(2, 0, pager_swipe_cb, NULL, BLACK);
+}
+
+void loop() {
+
+  detector.poll();
+  pager.idle();
+
+  // Catch up with the samples due since last time, and pass them in a block
+  // at a time.
+  while ((long)(micros() - next_sample) >= 0)
+  {
+    block[n_block++] = make_sample();
+    next_sample += SAMPLE_US;
+    if (n_block == BLOCK)
+    {
+      chart.addSamples(block, n_block);
+      n_block = 0;
+    }
+  }
+  GU_Frame::tick();
+}
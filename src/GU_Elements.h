@@ -3,28 +3,833 @@
 
 // UI elements for the Giga display.
 
+#include <new>
+#include <atomic>
 #include <Arduino_GigaDisplay_GFX.h>
 #include <GestureDetector.h>
 #include <FontCollection.h>
 
 // ---------------------------------------------------------------------------------
 
+// Direct access to the pixels of the Giga display's frame buffer.
+// The buffer is held in the panel's native (portrait) orientation, so the
+// address of a pixel and the steps between neighbouring pixels depend on
+// the rotation set on the GFX. This class does that arithmetic once, so that
+// rows and columns can be read, written and dumped without going through
+// drawPixel for every pixel.
+//
+// Frames can be dumped as BMP images (e.g. over Serial) to capture reference
+// images of the UI elements and compare them after changes.
+//
+// The shapes the UI elements are made of (rectangles, rounded rectangles and
+// circles) are drawn here as horizontal spans written straight into the buffer.
+// They give the same pixels as the Adafruit_GFX functions of the same names.
+// The spans of the corners and circles come from tables computed once for
+// each radius, so drawing a shape does no arithmetic per pixel.
+//
+// A GU_Surface can be accessed in the same way as the display.
+
+// Largest radius whose span table is kept, and the number of tables.
+// Larger corners and circles are drawn by Adafruit_GFX.
+#define GU_SPAN_MAX_RADIUS  63
+#define GU_SPAN_TABLES      8
+
+class GU_FrameBuffer
+{
+public:
+  // The GFX must be the GigaDisplay_GFX the UI elements are drawn on.
+  GU_FrameBuffer(Adafruit_GFX *gfx);
+  ~GU_FrameBuffer() {  }
+
+  // Is there a frame buffer to access? (not until the display is begun)
+  bool isValid(void) { return _origin != NULL; }
+
+  // Address of the pixel at (rotated) x/y. No clipping is done.
+  uint16_t *pixelAddr(int16_t x, int16_t y)
+            { return _origin + x * _xstep + y * _ystep; }
+
+  // Steps (in pixels) between horizontally and vertically adjacent pixels.
+  int xstep(void) { return _xstep; }
+  int ystep(void) { return _ystep; }
+
+  // Copy a rectangle of the screen out to a buffer of w * h pixels (row by row),
+  // or back in again. The rectangle must lie within the screen.
+  // For writeRect, the rows of the buffer may be longer than w (stride pixels),
+  // so a strip of a larger image can be written.
+  void readRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *pixels);
+  void writeRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *pixels, uint16_t stride = 0);
+
+  // Move the contents of a rectangle by dx/dy. The source and destination
+  // may overlap, and must both lie within the screen. The pixels left behind
+  // are not changed.
+  void moveRect(int16_t x, int16_t y, uint16_t w, uint16_t h, int16_t dx, int16_t dy);
+
+  // Draw a 1-bit bitmap (as held by a GFXcanvas1: rows of (w + 7) / 8 bytes,
+  // most significant bit first) in the given color. Clear bits are left alone.
+  // The bitmap is clipped to the screen.
+  void drawBits(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t *bits, uint16_t color);
+
+  // Shapes, drawn as Adafruit_GFX draws them, and clipped to the screen.
+  // If there is no frame buffer they are passed on to the GFX.
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+  void drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+  void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+  void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+
+  // Draw text with a font collection. This only differs from calling
+  // the font collection directly when a display list is recording.
+  void drawText(FontCollection *fc, char *str, int16_t x, int16_t y, uint16_t color, uint8_t textsize = 1);
+  // Single character version
+  void drawText(FontCollection *fc, char ch, int16_t x, int16_t y, uint16_t color, uint8_t textsize = 1)
+       { char text[2] = {ch, 0}; drawText(fc, text, x, y, color, textsize); }
+
+  // Blend a color over what is already in a rectangle (see rgb565_blend).
+  // With BLACK this darkens it, as behind a menu or sidebar. The rectangle
+  // is clipped to the screen. Nothing is done if there is no frame buffer.
+  void blendRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, uint8_t alpha);
+
+  // Allocate and free pixel buffers. These come from SDRAM, as buffers
+  // of screen-sized areas are too big for internal RAM.
+  static uint16_t *allocPixels(uint32_t n_pixels);
+  static void freePixels(uint16_t *pixels);
+
+  // Write a rectangle of the frame buffer to out as a 16-bit BMP image.
+  // If w or h are zero the whole screen is written.
+  void dumpFrame(Print *out, int16_t x = 0, int16_t y = 0, uint16_t w = 0, uint16_t h = 0);
+
+  // Draw text into a 1-bit bitmap of w x h pixels (which must be cleared),
+  // with the text origin at x/y within it.
+  static void rasterizeText(FontCollection *fc, char *str, uint8_t textsize,
+                            int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t *bits);
+
+private:
+  friend class GU_Stats;
+
+  Adafruit_GFX *_gfx;
+  uint16_t *_base;      // start of the buffer
+  uint16_t *_origin;    // address of pixel (0, 0)
+  int _xstep, _ystep;
+  bool _counting;       // pixel writes are being counted by GU_Stats
+
+  // Spans of one quadrant of a circle of radius r, for each row b (0 to r)
+  // above or below the centre. A filled circle covers 0 to fill[b] either side
+  // of the centre; the outline covers lo[b] to hi[b] (none if lo > hi).
+  typedef struct GU_SpanTable
+  {
+    int16_t r;
+    uint8_t fill[GU_SPAN_MAX_RADIUS + 1];
+    uint8_t lo[GU_SPAN_MAX_RADIUS + 1];
+    uint8_t hi[GU_SPAN_MAX_RADIUS + 1];
+  } GU_SpanTable;
+
+  static GU_SpanTable _tables[GU_SPAN_TABLES];
+  static int _n_tables;       // number of tables filled in
+  static int _next_table;     // table to fill in next
+
+  static GU_SpanTable *spanTable(int16_t r);
+  static uint32_t writeBMPHeader(Print *out, uint16_t w, uint16_t h);
+  void span(int16_t x1, int16_t x2, int16_t y, uint16_t color);
+  void blitBits(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t *bits, uint16_t color, bool draw);
+  void cornerSpans(GU_SpanTable *t, int16_t x0, int16_t y0, bool left, bool top, uint16_t color);
+};
+
+// An off-screen GFX that draws into a pixel buffer laid out as readRect
+// leaves it (row by row, w pixels per row). The buffer belongs to the caller,
+// and can be changed so one surface can draw into several buffers.
+// Surfaces are listed so GU_FrameBuffer can tell them from the display.
+class GU_Surface : public GFXcanvas16
+{
+public:
+  GU_Surface(uint16_t w, uint16_t h);
+  ~GU_Surface();
+
+  void setPixels(uint16_t *pixels) { buffer = pixels; }
+
+  // The surface a GFX is, or NULL if it is not one (i.e. it is the display)
+  static GU_Surface *find(Adafruit_GFX *gfx);
+
+private:
+  GU_Surface *_next;
+  static GU_Surface *_surfaces;
+};
+
+// The same for a 1-bit canvas, whose buffer is laid out as drawBits expects.
+class GU_BitSurface : public GFXcanvas1
+{
+public:
+  GU_BitSurface(uint16_t w, uint16_t h) : GFXcanvas1(w, h, false) {  }
+  ~GU_BitSurface() { buffer = NULL; }
+
+  void setBits(uint8_t *bits) { buffer = bits; }
+};
+
+// ---------------------------------------------------------------------------------
+
+// Display list. Between begin and end, what the UI elements draw on a GFX is
+// recorded instead of being drawn. At end, the commands are played back:
+// those completely covered by a later opaque fill are dropped, and fills are
+// drawn around the parts of them that later fills cover, so most pixels are
+// written once. Fills of the same color that adjoin are merged as they are
+// recorded.
+//
+// Only drawing done by the UI elements (or through GU_FrameBuffer) is recorded.
+// Anything drawn directly on the GFX while recording would be drawn over at
+// end, so draw it afterwards. Reading or copying the frame buffer plays back
+// what has been recorded so far first.
+
+#define GU_DISPLAY_LIST_SIZE    128     // commands held before they are played back
+#define GU_DISPLAY_LIST_BYTES   4096    // room for copies of label bitmaps and text
+#define GU_MAX_OCCLUDERS        32      // opaque fills looked at when culling
+
+class GU_DisplayList
+{
+public:
+  // Start recording drawing on the GFX.
+  static void begin(Adafruit_GFX *gfx);
+
+  // Play back what has been recorded and stop recording.
+  static void end(void);
+
+  // Play back what has been recorded so far, and carry on recording.
+  static void sync(void);
+
+  // Is drawing on this GFX being recorded?
+  static bool isRecording(Adafruit_GFX *gfx) { return _gfx != NULL && _gfx == gfx; }
+
+  // Commands recorded and dropped since begin (merged fills count once).
+  static void getStats(int *recorded, int *culled) { *recorded = _recorded; *culled = _culled; }
+
+private:
+  friend class GU_FrameBuffer;
+
+  enum { DL_FILL_RECT, DL_FILL_ROUND_RECT, DL_DRAW_ROUND_RECT,
+         DL_FILL_CIRCLE, DL_DRAW_CIRCLE, DL_BITS, DL_TEXT };
+
+  typedef struct GU_Rect
+  {
+    int16_t x1, y1, x2, y2;     // x2 and y2 are exclusive
+  } GU_Rect;
+
+  typedef struct GU_Command
+  {
+    uint8_t op;
+    uint8_t textsize;
+    int16_t x, y, w, h, r;      // circles are held by their bounding box
+    uint16_t color;
+    void *data;                 // copy of the bits or text
+    FontCollection *fc;
+    GU_Rect bounds;             // everything the command may draw on
+    int n_occluders;            // opaque fills drawn after it
+    bool culled;
+    void *widget;               // what drew it, for GU_Stats
+    uint8_t kind;
+  } GU_Command;
+
+  static Adafruit_GFX *_gfx;
+  static GU_Command _commands[GU_DISPLAY_LIST_SIZE];
+  static int _n_commands;
+  static uint8_t _bytes[GU_DISPLAY_LIST_BYTES];
+  static int _n_bytes;
+  static GU_Rect _occluders[GU_MAX_OCCLUDERS];
+  static int _n_occluders;
+  static int _recorded, _culled;
+
+  static GU_Command *record(uint8_t op, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+  static void recordFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  static void *copyData(void *data, int size);
+  static void addOccluder(int16_t x1, int16_t y1, int16_t x2, int16_t y2);
+  static void replay(void);
+  static void fillAround(GU_FrameBuffer *fb, GU_Command *c);
+};
+
+// ---------------------------------------------------------------------------------
+
+// Pixel write statistics. When started, every pixel the UI elements write to
+// the display is counted: per frame, per kind of element, and per element
+// (buttons, menus, pagers and sidebars). Optionally, the number of times each
+// pixel has been written in the frame is kept too, as a heatmap that can be
+// dumped as a BMP image like GU_FrameBuffer::dumpFrame. This shows where the
+// redraws write the same pixels over and over.
+//
+// Only drawing done through GU_FrameBuffer (i.e. by the UI elements) is counted.
+// When not started, the counting costs a test of a flag per span.
+
+// Number of elements counted separately. Any more are counted together.
+#define GU_STATS_WIDGETS  32
+
+typedef enum
+{
+  GU_STATS_OTHER,
+  GU_STATS_BUTTON,
+  GU_STATS_MENU,
+  GU_STATS_PAGER,
+  GU_STATS_SIDEBAR,
+  GU_STATS_KEYBOARD,
+  GU_STATS_BAR,           // progress bars and sliders
+  GU_STATS_CHART,
+  GU_STATS_KINDS
+} GU_StatsKind;
+
+class GU_Stats
+{
+public:
+  // Start counting writes to the display. The heatmap takes a byte per pixel
+  // of SDRAM; return false if it can't be had (the counts are still kept).
+  static bool begin(Adafruit_GFX *gfx, bool heatmap = true);
+
+  // Stop counting and free the heatmap.
+  static void end(void);
+
+  // Start a new frame. The frame counts and the heatmap are cleared.
+  static void nextFrame(void);
+
+  // Pixels written in this frame, and how many of them were written over
+  // a pixel already written in the frame (only counted with a heatmap).
+  static uint32_t frameWrites(void) { return _frame_writes; }
+  static uint32_t frameOverwrites(void) { return _frame_overwrites; }
+
+  // Pixels written, and frames, since begin.
+  static uint32_t totalWrites(void) { return _total_writes; }
+  static uint32_t frames(void) { return _frames; }
+
+  // Times a pixel has been written in this frame (up to 255).
+  static uint8_t pixelWrites(int16_t x, int16_t y);
+
+  // Pixels written by a kind of element since begin.
+  static uint32_t kindWrites(GU_StatsKind kind) { return _kind_writes[kind]; }
+
+  // Pixels written by each element since begin. Elements past the first
+  // GU_STATS_WIDGETS are counted together, with a NULL widget.
+  static int numWidgets(void) { return _n_widgets; }
+  static void getWidget(int i, void **widget, GU_StatsKind *kind, uint32_t *writes);
+
+  // Write the heatmap as a BMP image. Pixels not written are black; then
+  // blue, green, yellow and red for 1, 2, 3 and 4-7 writes, and white for more.
+  static void dumpHeatmap(Print *out);
+
+  // Called by the elements when they start to draw, so their writes are
+  // counted against them.
+  static void setWidget(void *widget, GU_StatsKind kind)
+              { _widget = widget; _kind = kind; _entry = -1; }
+  static void *getWidget(void) { return _widget; }
+  static GU_StatsKind getKind(void) { return _kind; }
+
+  static bool isCounting(Adafruit_GFX *gfx) { return _gfx != NULL && _gfx == gfx; }
+
+  // Count n pixel writes, starting at p and step pixels apart in the buffer.
+  static void countPixels(uint16_t *p, int n, int step);
+
+private:
+  typedef struct GU_WidgetStats
+  {
+    void *widget;
+    GU_StatsKind kind;
+    uint32_t writes;
+  } GU_WidgetStats;
+
+  static Adafruit_GFX *_gfx;
+  static uint16_t *_base;       // start of the display's buffer
+  static uint8_t *_heat;        // writes per pixel this frame, in buffer order
+  static uint32_t _n_pixels;
+  static uint32_t _frame_writes, _frame_overwrites, _total_writes, _frames;
+  static uint32_t _kind_writes[GU_STATS_KINDS];
+  static GU_WidgetStats _widgets[GU_STATS_WIDGETS + 1];
+  static int _n_widgets;
+  static void *_widget;         // element now drawing
+  static GU_StatsKind _kind;
+  static int _entry;            // its entry in _widgets, -1 if not looked up yet
+};
+
+// ---------------------------------------------------------------------------------
+
+// Frame scheduler. Changing an element (e.g. GU_Button::setText or setColor)
+// invalidates it rather than drawing it. By default, it is drawn straight away
+// as before. In deferred mode, it is put on a list, and tick() (called from
+// loop(), next to the gesture detector's poll) draws everything on the list
+// once, no more often than the frame rate. So changing the label and color of
+// 20 buttons draws each of them once, together, rather than 40 times.
+//
+// Drawing an element directly (e.g. with drawButton) still draws it
+// immediately, and takes it off the list.
+//
+// Animations (such as a menu still scrolling after a flick) are stepped by
+// tick() too, once a frame, in either mode, so nothing waits in a gesture
+// callback while they run. Sketches that use them must call tick().
+
+#define GU_FRAME_MAX_DIRTY  64      // elements held; if more, the frame is drawn early
+#define GU_FRAME_MAX_ANIMATIONS 8   // animations running at once
+#define GU_FRAME_RATE       30      // default frames per second
+
+// Callback to draw an invalidated element.
+typedef void (*RedrawCB)(void *element);
+
+// Callback to step an element's animation. Return false when it has finished.
+typedef bool (*AnimateCB)(void *element);
+
+class GU_Frame
+{
+public:
+  // Defer drawing invalidated elements to tick(), or draw them straight away.
+  static void setDeferred(bool deferred);
+  static bool isDeferred(void) { return _deferred; }
+
+  // Limit how often tick() draws a frame.
+  static void setFrameRate(uint8_t fps) { _frame_ms = fps > 0 ? 1000 / fps : 0; }
+
+  // Invalidate an element. The redraw callback is called with it when it
+  // is drawn (just once per frame, however many times it was invalidated).
+  static void invalidate(void *element, RedrawCB redraw);
+
+  // Take an element off the list (it has been drawn or destroyed).
+  static void validate(void *element);
+
+  // Call often. Draw the frame if anything is invalid and the frame interval
+  // has passed; return true if a frame was drawn.
+  static bool tick(void);
+
+  // Draw the invalid elements now.
+  static void flush(void);
+
+  // Elements waiting to be drawn.
+  static int numDirty(void) { return _n_dirty; }
+
+  // Step an element's animation each frame until it finishes or is stopped.
+  // Starting another for the same element replaces it. Return false if
+  // there is no room (the animation doesn't run).
+  static bool animate(void *element, AnimateCB step);
+  static void stopAnimation(void *element);
+
+  // Animations running.
+  static int numAnimating(void) { return _n_anim; }
+
+private:
+  typedef struct GU_Dirty
+  {
+    void *element;
+    RedrawCB redraw;
+  } GU_Dirty;
+
+  typedef struct GU_Animation
+  {
+    void *element;
+    AnimateCB step;
+  } GU_Animation;
+
+  static bool _deferred;
+  static unsigned long _frame_ms;
+  static unsigned long _last_frame;
+  static GU_Dirty _dirty[GU_FRAME_MAX_DIRTY];
+  static int _n_dirty;
+  static GU_Animation _anim[GU_FRAME_MAX_ANIMATIONS];
+  static int _n_anim;
+};
+
+// ---------------------------------------------------------------------------------
+
+// Latency probes. The time from a gesture callback being entered to the
+// drawing it causes being finished is measured for each kind of interaction
+// (menu taps, menu drags, swipes between pages, taps on the pager's dots,
+// key presses on keyboards and drags of sliders). Changes posted to the
+// render queue are timed from being posted to being made.
+// The times are kept in histograms of fixed size, from which percentiles are
+// read, or printed with dump (e.g. to Serial). The times include any sliding
+// of pages or flinging of menus, and any drawing done by the user's callbacks
+// that are called from them.
+//
+// The probes are only compiled in if GU_LATENCY is set to 1 here. Otherwise
+// they cost nothing, and the histograms stay empty.
+
+#ifndef GU_LATENCY
+#define GU_LATENCY  0
+#endif
+
+// Histogram buckets: one per microsecond up to 16us, then 4 per power of 2
+// (so each bucket is within 25% of its value) up to about 30 seconds.
+#define GU_LATENCY_BUCKETS  100
+
+typedef enum
+{
+  GU_LATENCY_MENU_TAP,    // tap on a menu's button, its items, or to cancel it
+  GU_LATENCY_MENU_DRAG,   // drag through or scrolling a menu
+  GU_LATENCY_SWIPE,       // swipe between pages
+  GU_LATENCY_DOTS,        // tap on the pager's dots
+  GU_LATENCY_KEY,         // press or release of a key on a keyboard
+  GU_LATENCY_SLIDER,      // drag of a slider
+  GU_LATENCY_QUEUE,       // change posted to GU_RenderQueue until it is made
+  GU_LATENCY_KINDS
+} GU_LatencyKind;
+
+#if GU_LATENCY
+#define GU_LATENCY_START(kind)  GU_Latency::start(kind)
+#define GU_LATENCY_STOP(kind)   GU_Latency::stop(kind)
+#define GU_LATENCY_RECORD(kind, us)   GU_Latency::record(kind, us)
+#else
+#define GU_LATENCY_START(kind)
+#define GU_LATENCY_STOP(kind)
+#define GU_LATENCY_RECORD(kind, us)
+#endif
+
+class GU_Latency
+{
+public:
+  // Called on entering a callback, and when its drawing is done.
+  static void start(GU_LatencyKind kind) { _start[kind] = micros(); }
+  static void stop(GU_LatencyKind kind);
+
+  // Add a time measured some other way.
+  static void record(GU_LatencyKind kind, uint32_t us);
+
+  // Number of interactions timed, and the time (in microseconds) that pct
+  // percent of them took no longer than. Percentiles are rounded up to the
+  // top of their bucket (but not beyond the longest).
+  static uint32_t count(GU_LatencyKind kind) { return _count[kind]; }
+  static uint32_t percentile(GU_LatencyKind kind, int pct);
+  static uint32_t longest(GU_LatencyKind kind) { return _max[kind]; }
+
+  // Empty the histograms.
+  static void reset(void);
+
+  // Print the count, p50, p95, p99 and longest for each kind.
+  static void dump(Print *out);
+
+private:
+  static unsigned long _start[GU_LATENCY_KINDS];
+  static uint32_t _count[GU_LATENCY_KINDS];
+  static uint32_t _max[GU_LATENCY_KINDS];
+  static uint32_t _buckets[GU_LATENCY_KINDS][GU_LATENCY_BUCKETS];
+
+  static int bucket(uint32_t us);
+  static uint32_t bucketTop(int b);
+};
+
+// ---------------------------------------------------------------------------------
+
+// Gesture traces. While recording, the gestures GestureDetector delivers to the
+// UI elements (taps, drags and swipes on menus, pagers, sidebars, registries,
+// keyboards and sliders)
+// are written with their timings into a compact binary trace. A trace can be
+// replayed later against the same elements, to reproduce a problem that
+// depends on timing, or to time the drawing as a performance test.
+//
+// The elements take the time from GU_Trace::now() and wait with GU_Trace::wait().
+// These are millis() and delay(), except while replaying, when they run a
+// virtual clock that only moves on as the trace says. So replays go as fast
+// as the drawing allows and always do the same thing.
+//
+// Events are held with the ids of the elements they went to. Menus, pagers,
+// sidebars, registries, keyboards and sliders take the first free id when
+// they are constructed and give it back when destroyed, so a trace replays
+// on a sketch that constructs the same elements in the same order as the
+// one that recorded it. Events for an id with no element are rejected.
+// Taps on buttons that call the sketch directly (not through a registry)
+// are not recorded. Gaps of more than a minute between events are
+// shortened to a minute.
+
+#define GU_TRACE_EVENT_SIZE   16        // bytes per event in a trace
+#define GU_TRACE_ELEMENTS     64        // elements that can be traced at once
+#define GU_TRACE_NO_ELEMENT   0xFFFF    // id of an element without one
+
+// The element callbacks that events are delivered to
+typedef enum
+{
+  GU_TRACE_MENU_TAP,
+  GU_TRACE_MENU_ITEM,
+  GU_TRACE_MENU_DRAG,
+  GU_TRACE_MENU_CANCEL,
+  GU_TRACE_PAGER_SWIPE,
+  GU_TRACE_DOTS,
+  GU_TRACE_SIDEBAR_CANCEL,
+  GU_TRACE_REGISTRY_TAP,
+  GU_TRACE_KEYBOARD,
+  GU_TRACE_SLIDER,
+  GU_TRACE_TARGETS
+} GU_TraceTarget;
+
+// What a replay did.
+typedef struct GU_TraceResult
+{
+  uint32_t events;      // events replayed
+  uint32_t rejected;    // events whose element couldn't be found
+  uint32_t frames;      // events, plus frames drawn by GU_Frame::tick
+  uint32_t draw_us;     // time spent drawing them (real time)
+  uint32_t max_us;      // longest of them
+  uint32_t trace_ms;    // length of the trace (virtual time)
+} GU_TraceResult;
+
+class GU_Trace
+{
+public:
+  // Start recording into a buffer of size bytes. Recording stops when it's full.
+  static void record(uint8_t *buf, uint32_t size);
+
+  // Stop recording. Return the length of the trace in bytes.
+  static uint32_t stop(void);
+
+  static bool isRecording(void) { return _buf != NULL; }
+
+  // Replay a trace of len bytes, and fill in the result. Return false if
+  // it isn't a trace.
+  static bool replay(const uint8_t *trace, uint32_t len, GU_TraceResult *result);
+
+  // Print a trace as a C array, to be pasted into a sketch and replayed
+  // (e.g. as a regression test).
+  static void dump(Print *out, const uint8_t *trace, uint32_t len);
+
+  // The time in ms, and a delay, for the elements to use.
+  static unsigned long now(void) { return _replaying ? _virtual_ms : millis(); }
+  static void wait(unsigned long ms) { if (_replaying) _virtual_ms += ms; else delay(ms); }
+
+  // Called by the element callbacks when an event arrives.
+  static void event(GU_TraceTarget target, EventType ev, int indx, void *param,
+                    int x, int y, int dx = 0, int dy = 0)
+              { if (_buf != NULL && !_replaying) add(target, ev, indx, param, x, y, dx, dy); }
+
+  // Called by the elements when they are constructed and destroyed, to give
+  // them an id that traces can hold.
+  static void addElement(void *element);
+  static void removeElement(void *element);
+
+private:
+  static uint8_t *_buf;
+  static uint32_t _size, _len;
+  static unsigned long _last_ms;
+  static bool _replaying;
+  static unsigned long _virtual_ms;
+  static void *_elements[GU_TRACE_ELEMENTS];    // by id, NULL if free
+
+  static int elementId(void *element);
+  static void add(GU_TraceTarget target, EventType ev, int indx, void *param,
+                  int x, int y, int dx, int dy);
+};
+
+// ---------------------------------------------------------------------------------
+
+// Text metrics cache. Measuring a string with getTextBounds walks every glyph,
+// so the results are cached, keyed by the string, font collection and text size.
+// The UI elements measure their text when it is set, and keep the bounds
+// for drawing.
+
+// Number of entries in the cache, and the longest string that will be cached.
+// Longer strings are still measured, they just aren't kept.
+#define GU_METRICS_ENTRIES  64
+#define GU_METRICS_MAXLEN   23
+
+// Bounds of a string drawn at (0, 0), as returned from getTextBounds.
+typedef struct GU_TextBounds
+{
+  int16_t   x, y;             // offset of top left from the text origin
+  uint16_t  w, h;
+} GU_TextBounds;
+
+class GU_TextMetrics
+{
+public:
+  // Get the bounds of a string, from the cache if it has been measured before.
+  static void getTextBounds(FontCollection *fc, char *str, uint8_t textsize, GU_TextBounds *bounds);
+
+  // Forget everything measured with a font collection (e.g. if its fonts
+  // are changed), or with all of them if fc is NULL. Buttons also
+  // rasterize their labels again the next time they are drawn.
+  static void flush(FontCollection *fc = NULL);
+
+  // Incremented by every flush, so anything derived from the metrics
+  // (such as rasterized labels) can tell when it is out of date.
+  static uint16_t generation(void) { return _generation; }
+
+private:
+  typedef struct GU_MetricsEntry
+  {
+    FontCollection  *fc;      // NULL if the entry is empty
+    uint8_t         textsize;
+    char            str[GU_METRICS_MAXLEN + 1];
+    GU_TextBounds   bounds;
+  } GU_MetricsEntry;
+
+  static GU_MetricsEntry _entries[GU_METRICS_ENTRIES];
+  static uint16_t _generation;
+};
+
+// ---------------------------------------------------------------------------------
+
+// Event slots. Elements that need events of their own in GestureDetector (the
+// pagers' swipes, and the buttons over their dots and beside their sidebars)
+// take them from here when they are set up and give them back when they are
+// taken down, so any number of pagers and sidebars can be up at once, one
+// inside a page of another.
+//
+// The top GU_SLOTS_MODAL events belong to the menus (only one menu is ever
+// displayed, so they share them). The slots handed out are in the band below
+// those. The lowest free slot in the band is taken, so an element set up while
+// another is up (such as a sidebar on a page of a pager) is above it, and gets
+// its gestures first. The indexes below the band are left for the user.
+
+#define GU_SLOTS_MODAL    4       // events used by a displayed menu
+#define GU_SLOTS_BAND     8       // slots handed out, below the menus' (up to 32)
+#define GU_SLOTS_FIRST    (MAX_EVENTS - GU_SLOTS_MODAL - GU_SLOTS_BAND)
+
+// The menus' events, highest priority first.
+#define GU_SLOT_MENU_BUTTON_DRAG  (MAX_EVENTS - 1)
+#define GU_SLOT_MENU_ITEM_TAP     (MAX_EVENTS - 2)
+#define GU_SLOT_MENU_ITEM_DRAG    (MAX_EVENTS - 3)
+#define GU_SLOT_MENU_CANCEL       (MAX_EVENTS - 4)
+
+class GU_Slots
+{
+public:
+  static_assert(GU_SLOTS_BAND > 0 && GU_SLOTS_BAND <= 32, "the band is held in one word");
+  static_assert(GU_SLOTS_FIRST >= 0, "MAX_EVENTS is too small for the slots");
+
+  // Take a free slot, or return -1 if they are all in use.
+  static int alloc(void);
+
+  // Give a slot back. Slots not handed out (and -1) are ignored.
+  static void free(int indx);
+
+  // Is this slot handed out?
+  static bool isAllocated(int indx)
+        { return indx >= GU_SLOTS_FIRST && indx < GU_SLOTS_FIRST + GU_SLOTS_BAND
+                 && (_used & (1UL << (indx - GU_SLOTS_FIRST))) != 0; }
+
+  // Slots still free.
+  static int numFree(void) { return GU_SLOTS_BAND - __builtin_popcount(_used); }
+
+private:
+  static uint32_t _used;      // bit n set if slot GU_SLOTS_FIRST + n is handed out
+};
+
+// ---------------------------------------------------------------------------------
+
+// The Registry class holds the sensitive areas of many elements (typically all
+// the buttons on a page) and routes taps to them, using only one event in
+// GestureDetector. Areas are kept in a grid of cells covering the screen, so
+// finding the area under a tap only looks at the few areas in one cell,
+// however many there are on the page.
+//
+// Areas are registered with onTap and cancelled with cancelEvent, as they
+// would be with GestureDetector. The index is both the identity of the area
+// and its priority: where areas overlap, the highest index wins.
+// An area with zero width or height catches taps that miss everything else.
+//
+// The registry's own event in GestureDetector covers the rectangle bounding
+// its areas (or the whole screen, if it has a catch-all area), and taps
+// outside it go on to lower events. Taps inside it that miss every area are
+// still taken by the registry, so lower events under the registered areas'
+// bounding rectangle are shadowed.
+// Buttons constructed with a registry register their areas in it.
+
+// Max number of areas in a registry, and of cells they can cover in total
+#define MAX_REGISTERED    256
+#define MAX_GRID_ENTRIES  (4 * MAX_REGISTERED)
+
+// Size of the grid (enough to cover 800 x 800 pixels in either rotation)
+#define GRID_CELL_SIZE    40
+#define GRID_COLS         20
+#define GRID_ROWS         20
+
+class GU_Registry
+{
+public:
+  friend void registry_tap_wrapper(EventType ev, int indx, void *param, int x, int y);
+
+  GU_Registry(GestureDetector *gd) { _gd = gd; clear(); GU_Trace::addElement(this); }
+  ~GU_Registry() { GU_Trace::removeElement(this); }
+
+  // Start routing taps, using a tap in GestureDetector at the given index
+  // that covers all the areas. Events at higher indexes still get their
+  // taps first.
+  void initRegistry(int indx);
+
+  // Stop routing taps and cancel all the areas.
+  void destroyRegistry(void);
+
+  // Register an area, as for GestureDetector::onTap. Registering an index
+  // that is already in use replaces its area.
+  bool onTap(int x, int y, int w, int h, TapCB callback, int indx, void *param);
+
+  // Cancel an area.
+  void cancelEvent(int indx);
+
+  // Cancel all the areas at once, but keep routing taps.
+  void cancelAll(void) { clear(); }
+
+  // Is an area registered at this index?
+  bool isEventRegistered(int indx)
+        { return indx >= 0 && indx < MAX_REGISTERED && _areas[indx].callback != NULL; }
+
+  // Find the area that a tap at x/y would go to, or -1 if none.
+  int hitTest(int x, int y);
+
+private:
+  typedef struct GU_Area
+  {
+    int16_t   x, y;
+    uint16_t  w, h;
+    TapCB     callback;     // NULL if not registered
+    void      *param;
+  } GU_Area;
+
+  typedef struct GU_GridEntry
+  {
+    int16_t   area;         // index of the area
+    int16_t   next;         // next entry in the cell, or -1
+  } GU_GridEntry;
+
+  GestureDetector *_gd;
+  int _indx = -1;
+  GU_Area _areas[MAX_REGISTERED];
+  int16_t _cells[GRID_ROWS * GRID_COLS];    // first entry in each cell, or -1
+  GU_GridEntry _entries[MAX_GRID_ENTRIES];
+  int16_t _free_entry;                      // list of unused entries
+  int _n_catchall;                          // number of zero-size areas
+  int _bx1, _by1, _bx2, _by2;               // extent of the other areas
+  int _pressed = -1;      // area that got the last press, to get its release
+
+  void clear(void);
+  void setBounds(int x1, int y1, int x2, int y2);
+  void removeEntries(int indx);
+  void cellRange(int i, int *c1, int *r1, int *c2, int *r2);
+  void registry_tap_cb(EventType ev, int indx, void *param, int x, int y);
+};
+
+// Wrapper
+void registry_tap_wrapper(EventType ev, int indx, void *param, int x, int y);
+
+// ---------------------------------------------------------------------------------
+
 // Provide a class to draw an Adafruit_GFX_Button with a custom font,
 // (the Adafruit button only works correctly with system font)
 // The custom font is drawn from a font collection, allowing buttons
 // to all have consistent fonts and sizes.
 
 // Also uses GestureDetector callbacks to signal button press/release.
+// Buttons may instead register their taps in a GU_Registry.
 
-class GU_Button
+// Labels are rasterized once into a 1-bit bitmap and blitted in the text color
+// when the button is drawn, instead of drawing the glyphs every time.
+// This is the total memory (in bytes) the bitmaps of all buttons may use.
+// Buttons that don't fit draw their labels as text.
+#define GU_LABEL_CACHE_SIZE 16384
+
+// The label is held in the button, so its length is fixed when the button is
+// declared. GU_Button holds labels of up to GU_BUTTON_LABEL_LEN - 1 characters;
+// GU_ButtonT<n> holds up to n - 1. Longer labels are cut short.
+#define GU_BUTTON_LABEL_LEN 10
+
+// The button's code, for any length of label.
+class GU_BasicButton
 {
 public:
-  friend class GU_Menu;
+  friend class GU_BasicMenu;
 
-  // If fc is NULL, nothing will be drawn, but the button will still pick up taps.
-  GU_Button(FontCollection *fc, GestureDetector *gd)
-            { _gd = gd; _fc = fc; _gfx = fc != NULL ? fc->_gfx : NULL; }
-  ~GU_Button() {  }
+  ~GU_BasicButton() { freeLabelBits(); GU_Frame::validate(this); }
+
+  // A button owns its rasterized label, so it can't be copied.
+  GU_BasicButton(const GU_BasicButton &) = delete;
+  GU_BasicButton &operator=(const GU_BasicButton &) = delete;
 
   // Set up the placement and appearance of a button.
 
@@ -41,7 +846,7 @@ public:
   //              (it will be multiplied by the size in the font collection)
   // callback     Tap callback as used by GestureDetector
   //              (may be NULL if a menu will be associated with the button)
-  // indx         Priority index of callback in GestureDetector
+  // indx         Priority index of callback in GestureDetector (or the registry)
   // param        User param to pass to callback
 
   void initButtonUL(int16_t x1, int16_t y1, uint16_t w, uint16_t h,
@@ -53,16 +858,17 @@ public:
   // Destroy the button.
   void destroyButton(void);
 
-  // Draw the button.
+  // Draw the button now.
   void drawButton(void);
 
-  // Set the text label of the button
+  // Set the text label of the button. The button is redrawn (at the next
+  // frame, if GU_Frame is deferring drawing).
   void setText(char *label);
   // Single character version
   void setText(char ch)
        { char text[2] = {ch, 0}; setText(text); }
 
-  // Set the colors used by a button
+  // Set the colors used by a button. The button is redrawn as for setText.
   void setColor(uint16_t outline, uint16_t fill, uint16_t textcolor);
 
   // Get the bounding rect of the button.
@@ -74,43 +880,112 @@ public:
     *h = _h;
   }
 
+  // Change the memory limit for rasterized labels (all buttons together).
+  // Bitmaps already made are kept, even if they are over the new limit.
+  static void setLabelCacheSize(uint32_t bytes) { _label_cache_size = bytes; }
+
+protected:
+  // If fc is NULL, nothing will be drawn, but the button will still pick up taps.
+  // The label buffer is label_len bytes, held by the subclass.
+  GU_BasicButton(FontCollection *fc, GestureDetector *gd, char *label, int label_len)
+            { _gd = gd; _reg = NULL; _fc = fc; _gfx = fc != NULL ? fc->_gfx : NULL;
+              _label = label; _label_len = label_len; }
+  GU_BasicButton(FontCollection *fc, GU_Registry *reg, char *label, int label_len)
+            { _gd = NULL; _reg = reg; _fc = fc; _gfx = fc != NULL ? fc->_gfx : NULL;
+              _label = label; _label_len = label_len; }
+
 private:
   Adafruit_GFX *_gfx;
   GestureDetector *_gd;
+  GU_Registry *_reg;
   FontCollection *_fc;
   int16_t _x1, _y1; // Coordinates of top-left corner
   uint16_t _w, _h;
   uint8_t _textsize;
   uint16_t _outlinecolor, _fillcolor, _textcolor;
-  char _label[10];
+  char *_label;
+  int _label_len;
+  GU_TextBounds _bounds;   // bounds of the label, measured when it is set
+  uint16_t _label_gen;     // metrics generation when the label was measured
+  uint8_t *_label_bits = NULL;  // rasterized label, _bounds.w x _bounds.h
+  uint16_t _label_bits_size = 0;
   bool _is_menu = false;
   int _indx;
+
+  static uint32_t _label_cache_size;  // limit, and memory used, by all labels
+  static uint32_t _label_cache_used;
+
+  void measureLabel(void);
+  bool rasterizeLabel(void);
+  void freeLabelBits(void);
+
+  // Register and cancel taps in the registry or GestureDetector.
+  void onTap(TapCB callback, int indx, void *param);
+  void cancelTap(int indx);
 };
 
+// A button holding labels of up to LabelLen - 1 characters.
+template <int LabelLen>
+class GU_ButtonT : public GU_BasicButton
+{
+public:
+  static_assert(LabelLen > 1, "button labels need room for the null");
+
+  GU_ButtonT(FontCollection *fc, GestureDetector *gd)
+            : GU_BasicButton(fc, gd, _label_buf, LabelLen) { }
+  GU_ButtonT(FontCollection *fc, GU_Registry *reg)
+            : GU_BasicButton(fc, reg, _label_buf, LabelLen) { }
+
+  // The base points into _label_buf, so a copy would share the original's.
+  GU_ButtonT(const GU_ButtonT &) = delete;
+  GU_ButtonT &operator=(const GU_ButtonT &) = delete;
+
+private:
+  char _label_buf[LabelLen];
+};
+
+typedef GU_ButtonT<GU_BUTTON_LABEL_LEN> GU_Button;
+
+void button_redraw_wrapper(void *param);
+
 // ---------------------------------------------------------------------------------
 
-// Max items in a menu
+// Max items in a menu, and the lengths of item labels and the tip (including
+// the null), for GU_Menu. GU_MenuT<items, label_len, tip_len> sets them for
+// one menu, so a short menu needn't take the room of a long one.
 #define MAX_ITEMS   20
+#define GU_MENU_LABEL_LEN   20
+#define GU_MENU_TIP_LEN     80
+
+// Callback to supply a menu item on demand, for menus with an item source.
+// Copy the label of item indx into label (len bytes including the null)
+// and set the enabled and checked flags (they default to enabled, unchecked).
+typedef void (*MenuItemCB)(int indx, char *label, int len, bool *enabled, bool *checked, void *param);
 
 // The Menu class:
 // - associates a drop-down menu with a button
 // - allows multiple menu items to be added
 // - allows menu items to be checked or disabled
 // - calls a callback when a menu item is selected
-// Internal callbacks are at events MAX_EVENTS -1, -2, -3 and -4
+// Internal callbacks are at the GU_SLOT_MENU_* events (MAX_EVENTS -1 to -4)
 // to be at the highest priority when menus are displayed.
-class GU_Menu
+// This is the menu's code, for any number and length of items; the items
+// are held by GU_MenuT (or GU_Menu).
+class GU_BasicMenu
 {
 public:
-  friend class GU_Button;
+  friend class GU_BasicButton;
   friend void menu_tap_wrapper(EventType ev, int indx, void *param, int x, int y);
   friend void menu_drag_wrapper(EventType ev, int indx, void *param, int x, int y, int dx, int dy);
   friend void menu_item_wrapper(EventType ev, int indx, void *param, int x, int y);
   friend void menu_cancel_wrapper(EventType ev, int indx, void *param, int x, int y);
+  friend bool menu_fling_wrapper(void *element);
+
+  ~GU_BasicMenu();
 
-  GU_Menu(FontCollection *fc, GestureDetector *gd)
-          { _gd = gd; _fc = fc; _gfx = fc->_gfx ;}
-  ~GU_Menu() {  }
+  // The menu points into its item and label storage, so it can't be copied.
+  GU_BasicMenu(const GU_BasicMenu &) = delete;
+  GU_BasicMenu &operator=(const GU_BasicMenu &) = delete;
 
   // Set up a menu associated with a button.
   // The menu item text sizes and height are derived from the button.
@@ -130,7 +1005,7 @@ public:
   //              by dragging or tapping outside the menu area.
   // param        User param to pass to callback
 
-  void initMenu(GU_Button *button,
+  void initMenu(GU_BasicButton *button,
                 uint16_t outline, uint16_t fill,
                 uint16_t highlight, uint16_t textcolor,
                 TapCB callback, int indx, void *param = NULL);
@@ -144,28 +1019,77 @@ public:
   void setMenuItem(int indx, char ch, bool enabled = true, bool checked = false, bool underlined = false)
                 { char item[2] = {ch, 0}; setMenuItem(indx, item, enabled, checked, underlined); }
 
-  // Disable/enable a menu item.
+  // Set up many items at once. Between beginMenuItems and commitMenuItems,
+  // setMenuItem only holds and measures each item; the menu is laid out and
+  // its button's tap registered once, at the commit.
+  void beginMenuItems(void) { _batching = true; }
+  void commitMenuItems(void);
+
+  // Set up items 0 to n_items - 1 (enabled and unchecked) from an array of
+  // labels, laying the menu out once.
+  void setMenuItems(char **labels, int n_items);
+
+  // Instead of setting up items one by one, supply them from a callback as
+  // they are displayed. Only the displayed rows are held, so the menu can
+  // have any number of items. The menu scrolls as usual.
+
+  // n_items      Total number of items in the menu.
+  // width        Width of the menu in pixels (items are not all measured).
+  // source       Callback to supply an item.
+  // param        User param to pass to the source callback.
+  void setItemSource(int n_items, uint16_t width, MenuItemCB source, void *param = NULL);
+
+  // Fetch an item again from the source (if it is displayed), and redraw it
+  // if the menu is up. Use this when the source's data for the item changes.
+  void refreshMenuItem(int indx);
+
+  // The item selected (-1 if none). This is valid within the callback, and is
+  // needed for menus with more than 254 items, whose index won't fit in a byte.
+  int getSelectedItem(void) { return _selected; }
+
+  // Disable/enable a menu item. If the menu is displayed, the item is redrawn.
   void enableMenuItem(int indx, bool enabled);
 
-  // Set the checkbox in a menu item.
+  // Set the checkbox in a menu item. If the menu is displayed, the item is redrawn.
+  // (Neither of these apply to menus with a source; use refreshMenuItem.)
   void checkMenuItem(int indx, bool checked);
 
   // Are we displaying a menu? (any menu, not just this instance)
-  bool isAnyMenuDisplayed(void) { return _gd->isEventRegistered(MAX_EVENTS - 4); }
+  bool isAnyMenuDisplayed(void) { return _gd->isEventRegistered(GU_SLOT_MENU_CANCEL); }
 
   // Set an optional menu tip (help text) to be displayed when menu is drawn.
   void setTip(char *tip);
 
-private:
+  // Save the pixels under the menu (and its tip) when it is displayed,
+  // and put them back when it is taken down, before the callback is called.
+  // The callback then doesn't need to redraw the screen.
+  // The pixels are kept in a buffer allocated when the menu is first displayed.
+  void setSaveUnder(bool save_under) { _save_under = save_under; }
+
+  // Darken the rest of the screen while the menu is displayed, by an amount
+  // from 0 (not at all, the default) to RGB565_ALPHA_MAX (to black).
+  // The screen is darkened where it is, rather than redrawn. With save-under,
+  // the whole screen is saved, so it can all be put back.
+  void setDimBehind(uint8_t amount) { _dim_behind = amount; }
+
+protected:
   typedef struct GU_MenuItem
   {
-    char      label[20];       // String to display on menu item
-    uint16_t  itemwidth;       // Width from getTextBounds
+    char      *label;          // String to display on menu item
+    uint16_t  itemwidth;       // Width from getTextBounds, plus room for check marks
+    GU_TextBounds bounds;      // Bounds of the label, measured when it is set
     bool      checked;         // Whether checked or enabled/disabled
     bool      enabled;
     bool      underlined;      // Whether item is drawn with a line
   } GU_MenuItem;
 
+  // The subclass holds max_items items, max_items + 1 labels of label_len
+  // bytes (the last is for _scratch) and a tip of tip_len bytes.
+  GU_BasicMenu(FontCollection *fc, GestureDetector *gd,
+               GU_MenuItem *items, int max_items, char *labels, int label_len,
+               char *tip, int tip_len);
+
+private:
   Adafruit_GFX *_gfx;
   GestureDetector *_gd;
   FontCollection *_fc;
@@ -174,37 +1098,205 @@ private:
   uint16_t _itemheight; // Height of a menu item comes from button
   uint8_t _textsize;  // Text size comes from the button
   uint16_t _outlinecolor, _fillcolor, _highlightcolor, _textcolor, _disabledtext;
-  GU_Button *_button;    // the associated button
-  GU_MenuItem _items[MAX_ITEMS];
+  GU_BasicButton *_button = NULL;   // the associated button
+  GU_MenuItem *_items;  // items, or the displayed rows if there is a source
+  int _max_items;
+  int _label_len;
+  MenuItemCB _source;   // item source, or NULL if items are set up one by one
+  void *_source_param;
+  int _cached_first;    // item held in _items[0] for a menu with a source
+  GU_MenuItem _scratch; // an item fetched from the source that isn't displayed
+  int _selected = -1;   // item last selected
   int _n_items;         // total number of items in the menu
   int _n_displayed;     // number actually displayed (if there isn't room for all of them)
   int _first_displayed; // index of top displayed item in menu
   int _max_displayed;    // the max number of items that can be displayed within screen height
-  char _tip[80];        // Menu tip (help text)
+  bool _batching = false; // items being set between beginMenuItems and commitMenuItems
+  char *_tip;           // Menu tip (help text)
+  int _tip_len;
+  GU_TextBounds _tip_bounds;
   TapCB _callback;
   int _indx;
   void *_param;
   uint16_t _em_width, _em_height;
   int _curr_item = -1;
   long _start_millis = 0; // counter timer for dwelling on a menu item
+  bool _displayed = false;  // this menu is currently on the screen
+  bool _save_under = false;
+  uint8_t _dim_behind = 0;  // amount to darken the screen behind the menu
+  uint16_t *_saved = NULL;  // pixels under the menu area then the tip bar (or the whole screen)
+  uint32_t _saved_size = 0; // size of the _saved buffer in pixels
+  int _drawn_first = -1;  // _first_displayed when the menu was last drawn
+  bool _scrolling = false;  // being scrolled by a drag in the arrow column
+  int _scroll_first;      // _first_displayed when the scrolling drag started
+  int _scroll_dy;         // drag distance at the last move
+  unsigned long _scroll_millis; // time of the last move
+  float _scroll_speed;    // in rows per second, +ve for scrolling down the list
+  float _fling_pos;       // first row displayed while flinging (fractional)
+  float _fling_speed;     // rows per second, as for _scroll_speed
+  unsigned long _fling_millis;  // time of the last fling step
 
   // Callback functons that assist with drawing the menu
   void menu_tap_cb(EventType ev, int indx, void *param, int x, int y);
   void menu_drag_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy);
   void menu_item_cb(EventType ev, int indx, void *param, int x, int y);
 
+  // Make room in the menu area for an item of width w and the rows displayed.
+  void growMenu(uint16_t w);
+
+  // Getting items from the source
+  GU_MenuItem *getItem(int i);
+  void fetchItem(int i, GU_MenuItem *item);
+  void fetchRows(void);
+
   // Menu drawing and navigation
+  void drawMenuItem(int i, bool highlight, bool outline);
+  bool isItemDisplayed(int i);
   void drawMenu(int highlight_item);
   void drawIfChanged(int item);
+  void drawScrolled(int scrolled, int item);
+  void scrollTo(int first);
+  void scrollDrag(EventType ev, int dy);
+  void fling(float speed);
+  bool flingStep(void);
+  void stopFling(void) { GU_Frame::stopAnimation(this); }
   int determineItem(int x, int y);
   void userCallbackAndCleanUp(int item, int x, int y);
+  void saveUnder(void);
+  void restoreUnder(void);
+  void dimBehind(void);
 };
 
+// A menu of up to Items items, with labels of up to LabelLen - 1 characters
+// and a tip of up to TipLen - 1.
+template <int Items, int LabelLen, int TipLen>
+class GU_MenuT : public GU_BasicMenu
+{
+public:
+  static_assert(Items > 0 && LabelLen > 1 && TipLen > 0, "menus need an item, and room for the nulls");
+
+  GU_MenuT(FontCollection *fc, GestureDetector *gd)
+          : GU_BasicMenu(fc, gd, _item_buf, Items, &_label_buf[0][0], LabelLen, _tip_buf, TipLen) { }
+
+  // The base points into the buffers below, so a copy would share them.
+  GU_MenuT(const GU_MenuT &) = delete;
+  GU_MenuT &operator=(const GU_MenuT &) = delete;
+
+private:
+  GU_MenuItem _item_buf[Items];
+  char _label_buf[Items + 1][LabelLen];
+  char _tip_buf[TipLen];
+};
+
+typedef GU_MenuT<MAX_ITEMS, GU_MENU_LABEL_LEN, GU_MENU_TIP_LEN> GU_Menu;
+
 // Wrappers to alow member functions to be passed as pointers
 void menu_tap_wrapper(EventType ev, int indx, void *param, int x, int y);
 void menu_drag_wrapper(EventType ev, int indx, void *param, int x, int y, int dx, int dy);
 void menu_item_wrapper(EventType ev, int indx, void *param, int x, int y);
 void menu_cancel_wrapper(EventType ev, int indx, void *param, int x, int y);
+bool menu_fling_wrapper(void *element);
+
+// ---------------------------------------------------------------------------------
+
+// A page arena holds the buttons and menus of one page. Rather than being
+// declared one by one, they are made in a fixed pool of memory, and register
+// their taps in the arena's own registry. reset() takes them all down at once:
+// the registry is emptied in one go (so a forgotten destroyButton can't leave
+// a sensitive area behind) and the pool is used again from the start (so
+// building the next page doesn't touch the heap).
+//
+// Elements are taken down newest first (a menu before its button), and their
+// destructors are run to give back label bitmaps, save-under buffers and a
+// menu's tap on its button, so reset() takes time for each element.
+// Given to a pager (setArena), the arena is reset as each page is left, and
+// the callback only has to build the page being shown.
+
+#define GU_ARENA_SIZE   4096    // bytes in the pool of a GU_Arena
+
+// The arena's code, for any size of pool. The pool is held by GU_ArenaT (or GU_Arena).
+class GU_BasicArena
+{
+public:
+  ~GU_BasicArena() { reset(); }
+
+  // Start routing taps to the arena's elements, from a catch-all tap in
+  // GestureDetector at the given index (see GU_Registry::initRegistry).
+  void begin(int indx) { _reg.initRegistry(indx); }
+
+  // Take everything down and stop routing taps.
+  void end(void) { reset(); _reg.destroyRegistry(); }
+
+  // Make a button (GU_Button or any GU_ButtonT) or a menu (GU_Menu or any
+  // GU_MenuT) in the pool. Set them up as usual; the index given to
+  // initButtonUL or initMenu is the index in the arena's registry.
+  // Returns NULL if there is no room left in the pool.
+  template <class Button = GU_Button>
+  Button *newButton(FontCollection *fc)
+  {
+    void *p = alloc(sizeof(Button), alignof(Button), destroyElement<Button>);
+    return p != NULL ? new (p) Button(fc, &_reg) : NULL;
+  }
+
+  template <class Menu = GU_Menu>
+  Menu *newMenu(FontCollection *fc)
+  {
+    void *p = alloc(sizeof(Menu), alignof(Menu), destroyElement<Menu>);
+    return p != NULL ? new (p) Menu(fc, _gd) : NULL;
+  }
+
+  // Take down all the elements, cancel all their taps and empty the pool.
+  // Pointers to the elements are no longer valid.
+  void reset(void);
+
+  // The registry the elements' taps are in.
+  GU_Registry *getRegistry(void) { return &_reg; }
+
+  // Memory used in the pool, and elements made since the last reset.
+  uint32_t bytesUsed(void) { return _used; }
+  int numElements(void) { return _n_elements; }
+
+protected:
+  // The pool is size bytes, held by the subclass.
+  GU_BasicArena(GestureDetector *gd, uint8_t *pool, uint32_t size) : _reg(gd)
+            { _gd = gd; _pool = pool; _size = size; }
+
+private:
+  typedef void (*DestroyCB)(void *element);
+
+  // Each element follows an entry linking it to the one made before.
+  typedef struct GU_ArenaEntry
+  {
+    struct GU_ArenaEntry *prev;
+    DestroyCB destroy;
+  } GU_ArenaEntry;
+
+  template <class T>
+  static void destroyElement(void *element) { ((T *)element)->~T(); }
+
+  void *alloc(uint32_t size, uint32_t align, DestroyCB destroy);
+
+  GestureDetector *_gd;
+  GU_Registry _reg;
+  uint8_t *_pool;
+  uint32_t _size;
+  uint32_t _used = 0;
+  GU_ArenaEntry *_last = NULL;  // newest element's entry
+  int _n_elements = 0;
+};
+
+// An arena with a pool of Bytes bytes.
+template <uint32_t Bytes>
+class GU_ArenaT : public GU_BasicArena
+{
+public:
+  GU_ArenaT(GestureDetector *gd) : GU_BasicArena(gd, _pool_buf, Bytes) { }
+
+private:
+  alignas(8) uint8_t _pool_buf[Bytes];
+};
+
+typedef GU_ArenaT<GU_ARENA_SIZE> GU_Arena;
 
 // ---------------------------------------------------------------------------------
 
@@ -216,15 +1308,17 @@ void menu_cancel_wrapper(EventType ev, int indx, void *param, int x, int y);
 // The callback is a DragCB whose index is passed as:
 // - page being hidden in high byte (or 0xFF if there isn't one)
 // - page being shown in low byte (or 0xFF if leaving the pager)
-// Since there is only one pager, no index is passed to init_pager()
-// (the real callback is hardcoded at MAX_EVENTS - 5)
+// No index is passed to init_pager(); the swipe (and any button the
+// subclass puts up) takes its event from GU_Slots, and gives it back in
+// destroyPager(). Pagers set up later are above those set up earlier.
 class GU_BasicPager
 {
 public:
   friend void pager_swipe_wrapper(EventType ev, int indx, void *param, int x, int y, int dx, int dy);
 
-  GU_BasicPager(GigaDisplay_GFX *gfx, GestureDetector *gd) { _gfx = gfx; _gd = gd; }
-  ~GU_BasicPager() {  }
+  GU_BasicPager(GigaDisplay_GFX *gfx, GestureDetector *gd)
+        { _gfx = gfx; _gd = gd; GU_Trace::addElement(this); }
+  ~GU_BasicPager() { GU_Trace::removeElement(this); }
 
   // Set up a pager to go from 0 to n_pages-1 pages. Clear screen to
   // the fill color and display the given first page.
@@ -244,12 +1338,52 @@ public:
   // that the page can be swiped. This might be dots at bottom (class Pager)
   // or a swipe indicator line at left or right (class Sidebar). This basic version
   // just clears the shole screen.
-  virtual void clearPage(bool indicator) { _gfx->fillScreen(_fillcolor); }
+  virtual void clearPage(bool indicator);
 
   // Go to a given page.
   void gotoPage(int page);
 
+  // Slide pages on and off, instead of changing them in one go. The content
+  // on the screen is moved across and only the newly exposed strip is drawn
+  // each frame. If a frame takes longer than frame_ms, the slide stops and
+  // the page is changed in one go. Zero frames (the default) turns sliding off.
+  void setSlide(uint8_t frames, uint16_t frame_ms = 20)
+                { _slide_frames = frames; _slide_ms = frame_ms; }
+
+  // Hold the pages' buttons and menus in an arena, which is reset as each
+  // page is left (before the callback), and when the pager is destroyed.
+  void setArena(GU_BasicArena *arena) { _arena = arena; }
+
 protected:
+  // Change pages: leave the current page, enter the new one and tell the user.
+  void showPage(int page, int x, int y, int dx, int dy);
+
+  // Called as a page is left, and as the next one is entered, to prepare it
+  // for the user's callback. Subclasses may keep or restore pages here.
+  virtual void leavePage(int page) {  }
+  virtual void enterPage(int page) { clearPage(true); }
+
+  // Slide from one page to another before entering it. Returns true if the
+  // slide finished. The basic version slides the whole screen.
+  virtual bool slidePage(int from, int to)
+                { return slideRegion(0, _gfx->width(), to > from, to); }
+
+  // Slide the contents of a band of the screen (x to x + w) left or right,
+  // calling drawSlideStrip to draw the newly exposed strip of the incoming
+  // page each frame.
+  bool slideRegion(int16_t x, uint16_t w, bool leftwards, int page);
+
+  // Draw a strip of the incoming page at screen x, w wide. Columns start at
+  // src_x within the incoming content. The basic version fills it.
+  virtual void drawSlideStrip(int page, int16_t x, uint16_t w, int16_t src_x);
+
+  // What GU_Stats counts the pager's drawing as.
+  virtual GU_StatsKind statsKind(void) { return GU_STATS_PAGER; }
+
+  // Cancel the pager's events and give their slots back, as it is destroyed.
+  // Subclasses with buttons of their own free those too.
+  virtual void freeSlots(void);
+
   Adafruit_GFX *_gfx;
   GestureDetector *_gd;
   int _num_pages = 1;
@@ -257,6 +1391,10 @@ protected:
   DragCB _callback;
   void *_param;
   uint16_t _fillcolor;
+  uint8_t _slide_frames = 0;
+  uint16_t _slide_ms;
+  int _swipe_slot = -1;   // event of the swipe, from GU_Slots
+  GU_BasicArena *_arena = NULL;
 
   // Callback functons
   void pager_swipe_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy);
@@ -266,12 +1404,25 @@ protected:
 void pager_swipe_wrapper(EventType ev, int indx, void *param, int x, int y, int dx, int dy);
 void dotsCB(EventType ev, int indx, void *param, int x, int y);
 
+// Callback to draw a page off-screen, into the GFX given.
+typedef void (*RenderCB)(int page, Adafruit_GFX *gfx, void *param);
+
 
 // ---------------------------------------------------------------------------------
 
 // The Pager class allows swiping between full-page images. A row of dots
 // is displayed at the bottom of each page, showing which one is currently
 // displayed. Swiping right/left or tapping the dots wll select diferent pages.
+//
+// Optionally, pages can be kept in a cache of off-screen surfaces in SDRAM.
+// A page is saved as it is left, and when it is shown again it is copied back
+// instead of being cleared. The callback can call isPageRestored() to see
+// if it needs to draw the page, or just set up its buttons and menus.
+// Given a render callback, the pager will also draw the pages either side
+// of the current one ahead of time, whenever idle() is called.
+
+// Max number of pages that can be cached
+#define MAX_CACHED_PAGES  8
 
 class GU_Pager : public GU_BasicPager
 {
@@ -279,8 +1430,9 @@ public:
   friend void dotsCB(EventType ev, int indx, void *param, int x, int y);
 
   //GU_Pager(GigaDisplay_GFX *gfx, GestureDetector *gd) { _gfx = gfx; _gd = gd; }
-  GU_Pager(GigaDisplay_GFX *gfx, GestureDetector *gd) : GU_BasicPager(gfx, gd) { }
-  ~GU_Pager() {  }
+  GU_Pager(GigaDisplay_GFX *gfx, GestureDetector *gd) : GU_BasicPager(gfx, gd), _dots_button(NULL, gd)
+          { for (int i = 0; i < MAX_CACHED_PAGES; i++) { _cache[i].page = -1; _cache[i].pixels = NULL; } }
+  ~GU_Pager();
 
   // Set up a pager to go from 0 to n_pages-1 pages. Clear screen to
   // the fill color and display the given first page.
@@ -296,12 +1448,64 @@ public:
   // This clearPage overrides the basic clearPage to display the dots.
   void clearPage(bool indicator);
 
+  // Keep pages in a cache of off-screen surfaces.
+
+  // budget       Max bytes of SDRAM to use for the cache. Each page takes
+  //              width * height * 2 bytes.
+  // render       Optional callback to draw a page ahead of time. It is passed
+  //              an off-screen GFX (see getRenderGFX) already cleared to the
+  //              fill color, and should draw the page's content into it.
+  // param        User param to pass to the render callback.
+  // A budget too small for a page turns the cache off and frees its memory,
+  // including the render GFX.
+  void enableCache(uint32_t budget, RenderCB render = NULL, void *param = NULL);
+
+  // The off-screen GFX that pages are rendered into. Text can be drawn on it
+  // with a FontCollection constructed on this GFX. NULL if there is no cache.
+  Adafruit_GFX *getRenderGFX(void) { return _surface; }
+
+  // Is the page being shown a copy from the cache? Valid within the callback.
+  bool isPageRestored(void) { return _restored; }
+
+  // Throw away a page from the cache (if its content has changed), or -1 for all.
+  void invalidatePage(int page);
+
+  // Call this from the loop when there is time to spare. The pages either side
+  // of the current page will be rendered, one per call, if not already cached.
+  void idle(void);
+
 private:
   // Display the row of dots at bottom of screen with the current page highlighted.
   void displayDots(bool dots);
 
-  // Points to the button overlaying the row of dots.
-  GU_Button *_dots_button;
+  // Save and restore pages in the cache.
+  void leavePage(int page);
+  void enterPage(int page);
+  void drawSlideStrip(int page, int16_t x, uint16_t w, int16_t src_x);
+  void freeSlots(void);
+  int findCachedPage(int page);
+  int allocCachedPage(int page, bool ahead);
+  void renderPage(int page);
+
+  // The button overlaying the row of dots, and its event from GU_Slots.
+  GU_Button _dots_button;
+  int _dots_slot = -1;
+
+  // Page cache
+  typedef struct GU_CachedPage
+  {
+    int       page;           // page held, or -1 if none
+    uint32_t  last_used;      // for LRU eviction
+    uint16_t  *pixels;        // w * h pixels, allocated when first needed
+  } GU_CachedPage;
+
+  GU_CachedPage _cache[MAX_CACHED_PAGES];
+  int _n_cache = 0;           // number of pages the budget allows
+  uint32_t _cache_clock = 0;
+  GU_Surface *_surface = NULL;
+  RenderCB _render = NULL;
+  void *_render_param;
+  bool _restored = false;
 };
 
 // Wrappers
@@ -320,8 +1524,8 @@ class GU_Sidebar : public GU_BasicPager
 {
 public:
   friend void cancelCB(EventType ev, int indx, void *param, int x, int y);
-  GU_Sidebar(GigaDisplay_GFX *gfx, GestureDetector *gd) : GU_BasicPager(gfx, gd) { }
-  ~GU_Sidebar() {  }
+  GU_Sidebar(GigaDisplay_GFX *gfx, GestureDetector *gd) : GU_BasicPager(gfx, gd), _cancel_button(NULL, gd) { }
+  ~GU_Sidebar() { GU_FrameBuffer::freePixels(_under); }
 
   // Set up a pager to go from 0 to n_pages-1 pages. Clear screen to
   // the fill color and display the given first page at full screen.
@@ -342,17 +1546,449 @@ public:
   // This clearPage overrides the basic clearPage to display the swipe indicator.
   void clearPage(bool indicator);
 
+  // Darken the main page where it shows beside a sidebar, by an amount from
+  // 0 (not at all, the default) to RGB565_ALPHA_MAX (to black). The main page
+  // is darkened where it is, when a sidebar is entered from it.
+  void setDimBehind(uint8_t amount) { _dim_behind = amount; }
+
 private:
-  GU_Button *_cancel_button;
+  // Sidebars slide on and off over the main page, rather than the whole screen.
+  bool slidePage(int from, int to);
+  bool slideSidebar(int16_t x, int side, bool left, bool opening);
+  void drawSlideStrip(int page, int16_t x, uint16_t w, int16_t src_x);
+  GU_StatsKind statsKind(void) { return GU_STATS_SIDEBAR; }
+  void freeSlots(void);
+
+  GU_Button _cancel_button;
+  int _cancel_slot = -1;  // event of the cancel button, from GU_Slots
   int _main_page;
   uint16_t _sidewidth;
   uint16_t _sidecolor;
   uint16_t _sideborder;
+  uint8_t _dim_behind = 0;
+  bool _dimmed = false;   // the main page beside the sidebar has been darkened
+  uint16_t *_under = NULL;  // the band of the main page under a sliding sidebar
 };
 
 void cancelCB(EventType ev, int indx, void *param, int x, int y);
 
 
+// ---------------------------------------------------------------------------------
+
+// An on-screen keyboard, with a text field above the keys. There are two
+// layouts, letters (with a shift key for a capital) and numbers and symbols,
+// switched by a key at the bottom left.
+//
+// The whole keyboard takes one event in GestureDetector. The key under a tap
+// is found from its row (by division) and then its place along the row.
+// Pressing a key redraws just that key, highlighted while it is held, and the
+// text field only draws the character typed or clears the one deleted, so
+// typing doesn't redraw the keyboard.
+//
+// The callback is called as each key is released, with the user's index in the
+// high byte and the key in the low byte: the character typed (with any shift),
+// GU_KEY_BACKSPACE or GU_KEY_ENTER. The text typed so far is got with getText().
+
+#define GU_KEYBOARD_TEXT_LEN  32    // longest text, including the null
+#define GU_KEYBOARD_ROWS      4
+#define GU_KEYBOARD_COLS      11    // most keys in a row
+
+// Keys that don't type a character
+#define GU_KEY_LAYOUT     '\x01'    // switch between letters and symbols
+#define GU_KEY_SHIFT      '\x02'    // capitalise the next letter
+#define GU_KEY_BACKSPACE  '\b'
+#define GU_KEY_ENTER      '\n'
+
+class GU_Keyboard
+{
+public:
+  friend void keyboard_tap_wrapper(EventType ev, int indx, void *param, int x, int y);
+
+  GU_Keyboard(FontCollection *fc, GestureDetector *gd)
+        { _fc = fc; _gd = gd; _gfx = fc->_gfx; GU_Trace::addElement(this); }
+  ~GU_Keyboard() { GU_Trace::removeElement(this); }
+
+  // Set up a keyboard and draw it.
+
+  // x1           The X coordinate of the top left of the text field
+  // y1           The Y coordinate of the top left of the text field
+  // w            Width of the field and the keyboard. The keys are w / 10 wide.
+  // h            Height of the field and the keys. The field and each row of
+  //              keys are h / 5 high.
+  // outline      Color of the key and field outlines (16-bit 5-6-5 standard)
+  // fill         Color of the key and field fill (16-bit 5-6-5 standard)
+  // highlight    Color of a key's fill while pressed, and of the shift key
+  //              while shifted (16-bit 5-6-5 standard)
+  // textcolor    Color of the key labels and the text (16-bit 5-6-5 standard)
+  // callback     Tap callback as used by GestureDetector
+  // indx         Priority index of the keyboard's event in GestureDetector.
+  //              The callback is called with this index in its high byte.
+  // param        User param to pass to callback
+  // textsize     The font magnification of the labels and text
+  void initKeyboard(int16_t x1, int16_t y1, uint16_t w, uint16_t h,
+                    uint16_t outline, uint16_t fill,
+                    uint16_t highlight, uint16_t textcolor,
+                    TapCB callback, int indx, void *param = NULL, uint8_t textsize = 1);
+
+  // Destroy the keyboard.
+  void destroyKeyboard(void);
+
+  // Draw the text field and the keys.
+  void drawKeyboard(void);
+
+  // Set the text in the field, redrawing the field. Text that doesn't fit
+  // is cut short.
+  void setText(char *text);
+
+  // The text typed so far.
+  char *getText(void) { return _text; }
+
+private:
+  Adafruit_GFX *_gfx;
+  GestureDetector *_gd;
+  FontCollection *_fc;
+  int16_t _x1, _y1;
+  uint16_t _w, _h;
+  uint16_t _row_h;        // height of the field, and of each row of keys
+  uint8_t _textsize;
+  uint16_t _outlinecolor, _fillcolor, _highlightcolor, _textcolor;
+  TapCB _callback;
+  int _indx;
+  void *_param;
+
+  // Layout. Keys are numbered row * GU_KEYBOARD_COLS + place in the row.
+  const char *const *_rows;   // the keys of each row, in the layout table
+  bool _symbols = false;
+  bool _shift = false;
+  int _pressed = -1;          // key held down
+  int16_t _key_x[GU_KEYBOARD_ROWS][GU_KEYBOARD_COLS + 1];  // left edges, then the right end
+
+  // Text, and the origin of each character (then of the next one)
+  char _text[GU_KEYBOARD_TEXT_LEN];
+  int _len = 0;
+  int16_t _char_x[GU_KEYBOARD_TEXT_LEN];
+  int16_t _text_y;          // baseline
+
+  void layout(void);
+  int hitTest(int x, int y);
+  char keyChar(int key);
+  void drawKey(int key, bool pressed);
+  void drawKeys(void);
+  void drawField(void);
+  uint16_t advance(char c);
+  bool addChar(char c);
+  void deleteChar(void);
+  void keyboard_tap_cb(EventType ev, int indx, void *param, int x, int y);
+};
+
+// Wrapper
+void keyboard_tap_wrapper(EventType ev, int indx, void *param, int x, int y);
+
+// ---------------------------------------------------------------------------------
+
+// A horizontal progress bar, filled from the left in proportion to its value.
+// Changing the value only draws the columns between the old and new ends of
+// the fill, so values can be set as often as they come in.
+//
+// The bar is drawn through GU_Frame. By default each new value is drawn
+// straight away; with GU_Frame deferring, values set faster than the frame
+// rate are coalesced, and tick() draws the bar once per frame, from where it
+// was last drawn to the latest value.
+
+class GU_ProgressBar
+{
+public:
+  GU_ProgressBar(GigaDisplay_GFX *gfx) { _gfx = gfx; }
+  ~GU_ProgressBar() { GU_Frame::validate(this); }
+
+  // Set up a progress bar and draw it.
+
+  // x1, y1       The top left of the bar
+  // w, h         Width and height of the bar, including its outline
+  // outline      Color of the outline (16-bit 5-6-5 standard)
+  // fill         Color of the filled part (16-bit 5-6-5 standard)
+  // background   Color of the unfilled part (16-bit 5-6-5 standard)
+  // min_value    The value of an empty bar
+  // max_value    The value of a full bar
+  // value        The value to start at
+  void initBar(int16_t x1, int16_t y1, uint16_t w, uint16_t h,
+               uint16_t outline, uint16_t fill, uint16_t background,
+               int32_t min_value, int32_t max_value, int32_t value);
+
+  // Destroy the bar.
+  void destroyBar(void) { GU_Frame::validate(this); }
+
+  // Draw all of the bar now.
+  void drawBar(void);
+
+  // Set the value (limited to the range). The bar is redrawn from its old
+  // value to the new one (at the next frame, if GU_Frame is deferring drawing).
+  void setValue(int32_t value);
+  int32_t getValue(void) { return _value; }
+
+protected:
+  // The columns inside the outline, from 0 to the inner width.
+  uint16_t innerWidth(void) { return _w - 2; }
+
+  // The column a value ends at, and the value at a column.
+  int16_t valueToPos(int32_t value);
+  int32_t posToValue(int16_t pos);
+
+  // Draw the columns from..to-1 inside the outline, for the current position.
+  void drawSpan(int16_t from, int16_t to);
+
+  // Draw the change from the position last drawn to the current one.
+  void drawDelta(void);
+
+  Adafruit_GFX *_gfx;
+  int16_t _x1, _y1;
+  uint16_t _w, _h;
+  uint16_t _outlinecolor, _fillcolor, _bgcolor, _thumbcolor;
+  int32_t _min, _max, _value;
+  int16_t _pos;               // column the fill ends at
+  int16_t _drawn_pos = -1;    // _pos when last drawn, or -1 if not drawn
+  uint16_t _thumb = 0;        // half width of the slider's thumb (none on a bar)
+
+  friend void bar_redraw_wrapper(void *param);
+};
+
+void bar_redraw_wrapper(void *param);
+
+// ---------------------------------------------------------------------------------
+
+// A slider is a progress bar with a thumb at the end of the fill that can be
+// dragged. Drags go through GestureDetector onDrag, and are drawn straight away
+// (not waiting for a frame), only redrawing the thumb's old and new places and
+// the columns between them.
+//
+// The callback is a DragCB, called as the thumb moves and when it is released
+// (EV_RELEASED), with the slider's index. Read the value with getValue().
+
+class GU_Slider : public GU_ProgressBar
+{
+public:
+  friend void slider_drag_wrapper(EventType ev, int indx, void *param, int x, int y, int dx, int dy);
+
+  GU_Slider(GigaDisplay_GFX *gfx, GestureDetector *gd) : GU_ProgressBar(gfx)
+        { _gd = gd; GU_Trace::addElement(this); }
+  ~GU_Slider() { GU_Trace::removeElement(this); }
+
+  // Set up a slider and draw it. The arguments are as for initBar, plus:
+
+  // thumbcolor   Color of the thumb (16-bit 5-6-5 standard). The thumb is
+  //              h / 2 wide.
+  // callback     Drag callback function
+  // indx         Priority index of callback in GestureDetector
+  // param        User param to pass to callback
+  void initSlider(int16_t x1, int16_t y1, uint16_t w, uint16_t h,
+                  uint16_t outline, uint16_t fill, uint16_t background, uint16_t thumbcolor,
+                  int32_t min_value, int32_t max_value, int32_t value,
+                  DragCB callback, int indx, void *param = NULL);
+
+  // Destroy the slider.
+  void destroySlider(void);
+
+private:
+  GestureDetector *_gd;
+  DragCB _callback;
+  int _indx;
+  void *_param;
+
+  void slider_drag_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy);
+};
+
+// Wrapper
+void slider_drag_wrapper(EventType ev, int indx, void *param, int x, int y, int dx, int dy);
+
+// ---------------------------------------------------------------------------------
+
+// A strip chart plots a stream of samples, scrolling to the left as they come
+// in. Each column of the plot is the range (min to max) of a number of samples,
+// so it can take samples much faster than there are columns to show them.
+// Finished columns are kept in a ring buffer, from which the whole chart can
+// be drawn again (e.g. when its page is shown again in a pager).
+//
+// The chart is drawn through GU_Frame. When it is drawn, what is already on
+// the screen is moved left, and only the new columns are drawn at the right.
+// With GU_Frame deferring, this happens once a frame however many columns
+// came in; otherwise, after each column.
+//
+// While hidden (e.g. while its page isn't shown) samples are still taken in,
+// but nothing is drawn; drawChart shows it again.
+
+#define GU_STRIPCHART_COLUMNS   800     // widest chart, and columns kept
+
+class GU_StripChart
+{
+public:
+  GU_StripChart(GigaDisplay_GFX *gfx) { _gfx = gfx; }
+  ~GU_StripChart() { GU_Frame::validate(this); }
+
+  // Set up a strip chart and draw it (empty).
+
+  // x1, y1       The top left of the plot area
+  // w, h         Width and height of the plot area (w at most GU_STRIPCHART_COLUMNS)
+  // background   Color of the plot area (16-bit 5-6-5 standard)
+  // trace        Color of the trace (16-bit 5-6-5 standard)
+  // min_value    The value at the bottom of the plot area
+  // max_value    The value at the top of the plot area
+  // per_column   Number of samples in each column
+  void initChart(int16_t x1, int16_t y1, uint16_t w, uint16_t h,
+                 uint16_t background, uint16_t trace,
+                 int16_t min_value, int16_t max_value, uint16_t per_column = 1);
+
+  // Stop drawing the chart, and forget its samples.
+  void destroyChart(void);
+
+  // Draw all of the chart now, and keep drawing it as samples come in.
+  void drawChart(void);
+
+  // Stop drawing the chart. Samples are still taken in.
+  void hideChart(void) { _shown = false; GU_Frame::validate(this); }
+
+  // Take in samples. Keep up with the data by passing them in blocks.
+  void addSample(int16_t value) { addSamples(&value, 1); }
+  void addSamples(const int16_t *values, int n);
+
+  // Forget the samples, and clear the plot area if shown.
+  void clear(void);
+
+  // Change the number of samples in each column (from the next column on).
+  void setSamplesPerColumn(uint16_t per_column) { _per_column = max(per_column, (uint16_t)1); }
+
+  // Columns finished since the chart was set up.
+  uint32_t numColumns(void) { return _n_columns; }
+
+private:
+  typedef struct GU_Envelope
+  {
+    int16_t lo, hi;
+  } GU_Envelope;
+
+  Adafruit_GFX *_gfx;
+  int16_t _x1, _y1;
+  uint16_t _w, _h;
+  uint16_t _bgcolor, _tracecolor;
+  int16_t _min, _max;
+  uint16_t _per_column;
+  bool _shown = false;
+
+  // The column being filled
+  uint16_t _n_acc = 0;
+  int16_t _acc_lo, _acc_hi;
+
+  // Finished columns. _head is where the next one goes.
+  GU_Envelope _ring[GU_STRIPCHART_COLUMNS];
+  uint16_t _head = 0;
+  uint16_t _n_ring = 0;       // columns held (up to _w)
+  uint32_t _n_columns = 0;
+  uint16_t _n_new = 0;        // columns not drawn yet (up to _w)
+
+  int16_t valueToY(int16_t value);
+  GU_Envelope *column(int age) { return &_ring[(_head + GU_STRIPCHART_COLUMNS - 1 - age) % GU_STRIPCHART_COLUMNS]; }
+  void drawColumn(GU_FrameBuffer *fb, int16_t x, int age);
+  void drawNew(void);
+
+  friend void chart_redraw_wrapper(void *param);
+};
+
+void chart_redraw_wrapper(void *param);
+
+// ---------------------------------------------------------------------------------
+
+// Render queue. Changes to elements (button labels and colors, bar and slider
+// values, strip chart samples) are posted to a queue and made later by
+// whoever drains it, so that code taking in data never waits for drawing.
+//
+// There is one queue, with one producer and one consumer. Posting never
+// blocks: if the queue is full, the change is dropped and false returned.
+// The two ends only share the head and tail counts, so no locks are needed.
+//
+// The queue can be drained from loop(), or by a render thread (an rtos
+// thread on mbed boards such as the Giga, and a std::thread in the host
+// build). The thread also polls the gesture detector and
+// ticks GU_Frame, so it does all the drawing and touch handling, and loop()
+// is left to take in data and post changes. Once the thread is started,
+// don't draw from anywhere else: set up the elements before starting it
+// (or in callbacks, which are called on the thread).
+
+#define GU_RENDER_QUEUE_SIZE  256     // changes held (a power of 2)
+#define GU_RENDER_TEXT_LEN    24      // longest label posted, including the null
+#define GU_RENDER_SAMPLES     12      // samples held by one change
+#define GU_RENDER_STACK       8192    // bytes of stack for the render thread
+#define GU_RENDER_POLL_MS     10      // how often the thread polls for touches
+
+class GU_RenderQueue
+{
+public:
+  // Post changes. Labels are copied (up to GU_RENDER_TEXT_LEN - 1 characters).
+  // Samples are copied too, in changes of GU_RENDER_SAMPLES; either all
+  // of them are posted or none are. Return false if the queue is full.
+  static bool setText(GU_BasicButton *button, char *label);
+  static bool setColor(GU_BasicButton *button, uint16_t outline, uint16_t fill, uint16_t textcolor);
+  static bool setValue(GU_ProgressBar *bar, int32_t value);
+  static bool addSamples(GU_StripChart *chart, const int16_t *values, int n);
+
+  // Post a call to redraw(element), for anything else.
+  static bool redraw(void *element, RedrawCB redraw);
+
+  // Make the changes posted so far, and return how many there were.
+  static int drain(void);
+
+  // Start a thread that drains the queue, polls gd (if given), calls
+  // idle(param) (if given, e.g. to idle a pager) and ticks GU_Frame.
+  // Return false if it can't be started.
+  static bool startThread(GestureDetector *gd = NULL, RedrawCB idle = NULL, void *param = NULL);
+
+  // Stop the thread, after the pass it is on, and wait for it to end.
+  // Changes still waiting are left in the queue.
+  static void stopThread(void);
+
+  // Changes waiting, posted and dropped since the start.
+  static int numWaiting(void) { return _head.load() - _tail.load(); }
+  static uint32_t numPosted(void) { return _posted; }
+  static uint32_t numDropped(void) { return _dropped; }
+
+private:
+  typedef enum
+  {
+    GU_RENDER_SET_TEXT,
+    GU_RENDER_SET_COLOR,
+    GU_RENDER_SET_VALUE,
+    GU_RENDER_ADD_SAMPLES,
+    GU_RENDER_REDRAW
+  } GU_RenderKind;
+
+  typedef struct GU_RenderCommand
+  {
+    uint8_t kind;
+    uint8_t n;                  // samples held
+    uint32_t posted;            // micros() when posted
+    void *element;
+    union
+    {
+      char text[GU_RENDER_TEXT_LEN];
+      uint16_t colors[3];
+      int32_t value;
+      int16_t samples[GU_RENDER_SAMPLES];
+      RedrawCB redraw;
+    };
+  } GU_RenderCommand;
+
+  // Counts of changes posted (by the producer) and made (by the consumer).
+  // They run on past the size of the queue; the slot is the count modulo it.
+  static GU_RenderCommand _queue[GU_RENDER_QUEUE_SIZE];
+  static std::atomic<uint32_t> _head;
+  static std::atomic<uint32_t> _tail;
+  static uint32_t _posted;
+  static uint32_t _dropped;
+
+  static GU_RenderCommand *reserve(int n);
+  static void publish(GU_RenderCommand *cmd, int kind, void *element);
+  static void run(GU_RenderCommand *cmd);
+  static void wakeThread(void);
+};
+
 // ---------------------------------------------------------------------------------
 
 // Useful colour stuff not belonging to any class in particular
@@ -361,6 +1997,23 @@ uint16_t rgb565_average(uint16_t color1, uint16_t color2);
 void rgb565_unpack(uint16_t color, uint8_t *red, uint8_t *green, uint8_t *blue);
 uint16_t rgb565_pack(uint8_t red, uint8_t green, uint8_t blue);
 
+// Blending. Alphas (and darkening amounts) go from 0 to RGB565_ALPHA_MAX.
+#define RGB565_ALPHA_MAX  32
+
+// Blend color1 over color2 (alpha 0 gives color2, RGB565_ALPHA_MAX gives color1).
+uint16_t rgb565_blend(uint16_t color1, uint16_t color2, uint8_t alpha);
+
+// The same on spans of n pixels, working in place on dst. Spans may start at
+// any pixel, but are quickest when dst and src are both on even addresses.
+// average: dst = average of dst and src
+// blend:   dst = src blended over dst
+// mix:     dst = color blended over dst
+// darken:  dst = dst blended towards black (amount 16 halves it)
+void rgb565_average_span(uint16_t *dst, const uint16_t *src, int n);
+void rgb565_blend_span(uint16_t *dst, const uint16_t *src, int n, uint8_t alpha);
+void rgb565_mix_span(uint16_t *dst, int n, uint16_t color, uint8_t alpha);
+void rgb565_darken_span(uint16_t *dst, int n, uint8_t amount);
+
 // Colours in RGB565.
 #define RGB565_PACK(red, green, blue) ((red & 0xF8) << 8) | ((green & 0xFC) << 3) | (blue >> 3)
 
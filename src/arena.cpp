@@ -0,0 +1,38 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+
+// Page arena.
+
+// Take room for an element, just after an entry linking it to the one before.
+// The element is aligned as it needs, and the entry (being no bigger than
+// that alignment, in pointers) is aligned too.
+void *GU_BasicArena::alloc(uint32_t size, uint32_t align, DestroyCB destroy)
+{
+  uintptr_t at = (uintptr_t)_pool + _used + sizeof(GU_ArenaEntry);
+  GU_ArenaEntry *entry;
+
+  if (align < alignof(GU_ArenaEntry))
+    align = alignof(GU_ArenaEntry);
+  at = (at + align - 1) & ~(uintptr_t)(align - 1);
+  if (at - (uintptr_t)_pool + size > _size)
+    return NULL;
+
+  entry = (GU_ArenaEntry *)(at - sizeof(GU_ArenaEntry));
+  entry->prev = _last;
+  entry->destroy = destroy;
+  _last = entry;
+  _used = at - (uintptr_t)_pool + size;
+  _n_elements++;
+  return (void *)at;
+}
+
+// Take the elements down, newest first, then empty the registry and the pool.
+void GU_BasicArena::reset(void)
+{
+  for (GU_ArenaEntry *e = _last; e != NULL; e = e->prev)
+    (*e->destroy)((void *)(e + 1));
+  _reg.cancelAll();
+  _last = NULL;
+  _used = 0;
+  _n_elements = 0;
+}
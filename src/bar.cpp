@@ -0,0 +1,168 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+
+// Progress bars and sliders.
+
+void GU_ProgressBar::initBar(int16_t x1, int16_t y1, uint16_t w, uint16_t h,
+                            uint16_t outline, uint16_t fill, uint16_t background,
+                            int32_t min_value, int32_t max_value, int32_t value)
+{
+  _x1 = x1;
+  _y1 = y1;
+  _w = w;
+  _h = h;
+  _outlinecolor = outline;
+  _fillcolor = fill;
+  _bgcolor = background;
+  _min = min_value;
+  _max = max_value > min_value ? max_value : min_value + 1;
+  _value = constrain(value, _min, _max);
+  _pos = valueToPos(_value);
+  drawBar();
+}
+
+// Positions run from _thumb to the inner width less _thumb, so a slider's
+// thumb stays inside the outline.
+int16_t GU_ProgressBar::valueToPos(int32_t value)
+{
+  int32_t travel = innerWidth() - 2 * _thumb;
+
+  return _thumb + (int64_t)(value - _min) * travel / (_max - _min);
+}
+
+int32_t GU_ProgressBar::posToValue(int16_t pos)
+{
+  int32_t travel = innerWidth() - 2 * _thumb;
+
+  pos = constrain(pos, (int16_t)_thumb, (int16_t)(_thumb + travel));
+  return _min + ((int64_t)(pos - _thumb) * (_max - _min) + travel / 2) / travel;
+}
+
+void GU_ProgressBar::drawBar(void)
+{
+  GU_FrameBuffer fb(_gfx);
+
+  GU_Frame::validate(this);
+  GU_Stats::setWidget(this, GU_STATS_BAR);
+  fb.drawRect(_x1, _y1, _w, _h, _outlinecolor);
+  drawSpan(0, innerWidth());
+  _drawn_pos = _pos;
+}
+
+void GU_ProgressBar::setValue(int32_t value)
+{
+  int16_t pos;
+
+  _value = constrain(value, _min, _max);
+  pos = valueToPos(_value);
+  if (pos == _pos)
+    return;
+  _pos = pos;
+  GU_Frame::invalidate(this, bar_redraw_wrapper);
+}
+
+// Fill to the left of the position, and clear to the right of it. A slider's
+// thumb is drawn over the position.
+void GU_ProgressBar::drawSpan(int16_t from, int16_t to)
+{
+  int16_t x = _x1 + 1;
+  int16_t y = _y1 + 1;
+  uint16_t h = _h - 2;
+  GU_FrameBuffer fb(_gfx);
+  int16_t split;
+
+  from = max(from, (int16_t)0);
+  to = min(to, (int16_t)innerWidth());
+  if (from >= to)
+    return;
+
+  GU_Stats::setWidget(this, GU_STATS_BAR);
+  if (_thumb == 0)
+  {
+    split = constrain(_pos, from, to);
+    fb.fillRect(x + from, y, split - from, h, _fillcolor);
+    fb.fillRect(x + split, y, to - split, h, _bgcolor);
+    return;
+  }
+
+  // Fill, thumb, then background, each clipped to the span.
+  split = constrain((int16_t)(_pos - _thumb), from, to);
+  fb.fillRect(x + from, y, split - from, h, _fillcolor);
+  from = split;
+  split = constrain((int16_t)(_pos + _thumb), from, to);
+  fb.fillRect(x + from, y, split - from, h, _thumbcolor);
+  fb.fillRect(x + split, y, to - split, h, _bgcolor);
+}
+
+// Only the columns between the old and new positions change (and, on a
+// slider, the thumb at each end).
+void GU_ProgressBar::drawDelta(void)
+{
+  if (_drawn_pos < 0)
+  {
+    drawBar();
+    return;
+  }
+  drawSpan(min(_drawn_pos, _pos) - _thumb, max(_drawn_pos, _pos) + _thumb);
+  _drawn_pos = _pos;
+}
+
+// Wrapper outside the class so it can be passed as a function pointer.
+void bar_redraw_wrapper(void *param)
+{
+  GU_ProgressBar *bar = (GU_ProgressBar *)param;
+
+  bar->drawDelta();
+}
+
+// ---------------------------------------------------------------------------------
+
+// Slider.
+
+void GU_Slider::initSlider(int16_t x1, int16_t y1, uint16_t w, uint16_t h,
+                          uint16_t outline, uint16_t fill, uint16_t background, uint16_t thumbcolor,
+                          int32_t min_value, int32_t max_value, int32_t value,
+                          DragCB callback, int indx, void *param)
+{
+  _thumbcolor = thumbcolor;
+  _thumb = max(h / 4, 1);
+  _callback = callback;
+  _indx = indx;
+  _param = param;
+  initBar(x1, y1, w, h, outline, fill, background, min_value, max_value, value);
+
+  _gd->onDrag(_x1, _y1, _w, _h, slider_drag_wrapper, _indx, (void *)this);
+}
+
+void GU_Slider::destroySlider(void)
+{
+  _gd->cancelEvent(_indx);
+  destroyBar();
+}
+
+// Move the thumb to where the drag has got to, and draw it now rather than
+// at the next frame.
+void GU_Slider::slider_drag_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
+{
+  int32_t value = posToValue(x + dx - (_x1 + 1));
+
+  if (value != _value)
+  {
+    _value = value;
+    _pos = valueToPos(_value);
+    GU_Frame::validate(this);
+    drawDelta();
+  }
+  if (_callback != NULL)
+    (*_callback)(ev, _indx, _param, x, y, dx, dy);
+}
+
+void slider_drag_wrapper(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
+{
+  GU_Slider *slider = (GU_Slider *)param;
+
+  GU_Trace::event(GU_TRACE_SLIDER, ev, indx, param, x, y, dx, dy);
+  GU_LATENCY_START(GU_LATENCY_SLIDER);
+  slider->slider_drag_cb(ev, indx, param, x, y, dx, dy);
+  GU_LATENCY_STOP(GU_LATENCY_SLIDER);
+}
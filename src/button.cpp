@@ -1,8 +1,11 @@
 #include "Arduino.h"
 #include "GU_Elements.h"
 
+uint32_t GU_BasicButton::_label_cache_size = GU_LABEL_CACHE_SIZE;
+uint32_t GU_BasicButton::_label_cache_used = 0;
+
 // Set up a button.
-void GU_Button::initButtonUL(int16_t x1, int16_t y1, uint16_t w, uint16_t h,
+void GU_BasicButton::initButtonUL(int16_t x1, int16_t y1, uint16_t w, uint16_t h,
                             uint16_t outline, uint16_t fill,
                             uint16_t textcolor, char *label,
                             uint8_t textsize,
@@ -17,76 +20,154 @@ void GU_Button::initButtonUL(int16_t x1, int16_t y1, uint16_t w, uint16_t h,
   _fillcolor = fill;
   _textcolor = textcolor;
   _textsize = textsize;
-  strncpy(_label, label, 9);
-  _label[9] = 0; // strncpy does not place a null at the end.
-                // When 'label' is >9 characters, _label is not terminated.
+  strncpy(_label, label, _label_len - 1);
+  _label[_label_len - 1] = 0; // strncpy does not place a null at the end.
+                // When 'label' is too long, _label is not terminated.
+  measureLabel();
   _indx = indx;
   if (callback != NULL)
-    _gd->onTap(_x1, _y1, _w, _h, callback, indx, param);
+    onTap(callback, indx, param);
   else
     // We expect a menu to be triggered by this button, and will call its callback instead
     _is_menu = true;
 }
 
 // Destroy the button.
-void GU_Button::destroyButton(void)
+void GU_BasicButton::destroyButton(void)
 {
   if (!_is_menu)
-    _gd->cancelEvent(_indx);
+    cancelTap(_indx);
+  freeLabelBits();
+  GU_Frame::validate(this);
 }
 
-// Draw a button.
-void GU_Button::drawButton(void)
+// Register a tap on the button's area, with the registry if it has one.
+void GU_BasicButton::onTap(TapCB callback, int indx, void *param)
 {
-  int16_t x, y;
-  uint16_t w, h;
+  if (_reg != NULL)
+    _reg->onTap(_x1, _y1, _w, _h, callback, indx, param);
+  else
+    _gd->onTap(_x1, _y1, _w, _h, callback, indx, param);
+}
 
+void GU_BasicButton::cancelTap(int indx)
+{
+  if (_reg != NULL)
+    _reg->cancelEvent(indx);
+  else
+    _gd->cancelEvent(indx);
+}
+
+// Draw a button.
+void GU_BasicButton::drawButton(void)
+{
   // If there is no FC, there is no GFX, and we cannot display anything.
   if (_fc == NULL)
     return;
 
+  GU_FrameBuffer fb(_gfx);
+
+  GU_Frame::validate(this);
+  GU_Stats::setWidget(this, GU_STATS_BUTTON);
+
   // If button is associated with a menu, draw it square
   if (_is_menu)
   {
-    _gfx->fillRect(_x1, _y1, _w, _h, _fillcolor);
-    _gfx->drawRect(_x1, _y1, _w, _h, _outlinecolor);
+    fb.fillRect(_x1, _y1, _w, _h, _fillcolor);
+    fb.drawRect(_x1, _y1, _w, _h, _outlinecolor);
   }
   else
   {
     uint8_t r = min(_w, _h) / 4; // Corner radius
-    _gfx->fillRoundRect(_x1, _y1, _w, _h, r, _fillcolor);
-    _gfx->drawRoundRect(_x1, _y1, _w, _h, r, _outlinecolor);
+    fb.fillRoundRect(_x1, _y1, _w, _h, r, _fillcolor);
+    fb.drawRoundRect(_x1, _y1, _w, _h, r, _outlinecolor);
   }
 
   // Original code for system font only
   //_gfx->setCursor(_x1 + (_w / 2) - (strlen(_label) * 3 * _textsize_x),
   //                _y1 + (_h / 2) - (4 * _textsize_y));
 
-  _fc->getTextBounds(_label, _x1, _y1, &x, &y, &w, &h, _textsize);
 #if 0
   {
     char buf[64];
-    sprintf(buf, "x/y %d %d xywh %d %d %d %d", _x1, _y1, x, y, w, h);
+    sprintf(buf, "x/y %d %d xywh %d %d %d %d", _x1, _y1, _bounds.x, _bounds.y, _bounds.w, _bounds.h);
     Serial.println(buf);
   }
 #endif
 
+  // If the fonts have changed since the label was measured, measure it again.
+  if (_label_gen != GU_TextMetrics::generation())
+    measureLabel();
+
   // System font is drawn from the upper left, but custom fonts are
-  // drawn from the lower left. Adjust by the Y returned from getTextBounds().
-  _fc->drawText(_label, _x1 + (_w / 2) - (w / 2), _y1 + (_h / 2) - (h / 2) + (_y1 - y), _textcolor, _textsize);
+  // drawn from the lower left. Adjust by the Y offset from getTextBounds().
+  int16_t text_x = _x1 + (_w / 2) - (_bounds.w / 2);
+  int16_t text_y = _y1 + (_h / 2) - (_bounds.h / 2) - _bounds.y;
+
+  if (fb.isValid() && rasterizeLabel())
+    fb.drawBits(text_x + _bounds.x, text_y + _bounds.y, _bounds.w, _bounds.h, _label_bits, _textcolor);
+  else
+    fb.drawText(_fc, _label, text_x, text_y, _textcolor, _textsize);
 }
 
-void GU_Button::setText(char *label)
+// Measure the label. Any bitmap of the old label is no longer any good.
+void GU_BasicButton::measureLabel(void)
 {
-  strncpy(_label, label, 9);
-  _label[9] = 0; // strncpy does not place a null at the end.
-  drawButton();
+  GU_TextMetrics::getTextBounds(_fc, _label, _textsize, &_bounds);
+  _label_gen = GU_TextMetrics::generation();
+  freeLabelBits();
 }
 
-void GU_Button::setColor(uint16_t outline, uint16_t fill, uint16_t textcolor)
+// Rasterize the label into a 1-bit bitmap the size of its bounds. Return false
+// if there is no bitmap (nothing to draw, or no room for it).
+bool GU_BasicButton::rasterizeLabel(void)
+{
+  uint16_t size = (_bounds.w + 7) / 8 * _bounds.h;
+
+  if (_label_bits != NULL)
+    return true;
+  if (size == 0 || _label_cache_used + size > _label_cache_size)
+    return false;
+  _label_bits = (uint8_t *)calloc(size, 1);
+  if (_label_bits == NULL)
+    return false;
+  _label_bits_size = size;
+  _label_cache_used += size;
+  GU_FrameBuffer::rasterizeText(_fc, _label, _textsize, -_bounds.x, -_bounds.y,
+                                _bounds.w, _bounds.h, _label_bits);
+  return true;
+}
+
+void GU_BasicButton::freeLabelBits(void)
+{
+  if (_label_bits == NULL)
+    return;
+  free(_label_bits);
+  _label_bits = NULL;
+  _label_cache_used -= _label_bits_size;
+  _label_bits_size = 0;
+}
+
+void GU_BasicButton::setText(char *label)
+{
+  strncpy(_label, label, _label_len - 1);
+  _label[_label_len - 1] = 0; // strncpy does not place a null at the end.
+  measureLabel();
+  GU_Frame::invalidate(this, button_redraw_wrapper);
+}
+
+void GU_BasicButton::setColor(uint16_t outline, uint16_t fill, uint16_t textcolor)
 {
   _outlinecolor = outline;
   _fillcolor = fill;
   _textcolor = textcolor;
-  drawButton();
-}
\ No newline at end of file
+  GU_Frame::invalidate(this, button_redraw_wrapper);
+}
+
+// Wrapper outside the class so it can be passed as a function pointer.
+void button_redraw_wrapper(void *param)
+{
+  GU_BasicButton *button = (GU_BasicButton *)param;
+
+  button->drawButton();
+}
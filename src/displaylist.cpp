@@ -0,0 +1,308 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+
+// Display list.
+
+Adafruit_GFX *GU_DisplayList::_gfx = NULL;
+GU_DisplayList::GU_Command GU_DisplayList::_commands[GU_DISPLAY_LIST_SIZE];
+int GU_DisplayList::_n_commands = 0;
+uint8_t GU_DisplayList::_bytes[GU_DISPLAY_LIST_BYTES];
+int GU_DisplayList::_n_bytes = 0;
+GU_DisplayList::GU_Rect GU_DisplayList::_occluders[GU_MAX_OCCLUDERS];
+int GU_DisplayList::_n_occluders = 0;
+int GU_DisplayList::_recorded = 0;
+int GU_DisplayList::_culled = 0;
+
+void GU_DisplayList::begin(Adafruit_GFX *gfx)
+{
+  if (_gfx != NULL)
+    end();
+  _gfx = gfx;
+  _n_commands = 0;
+  _n_bytes = 0;
+  _recorded = 0;
+  _culled = 0;
+}
+
+void GU_DisplayList::end(void)
+{
+  sync();
+  _gfx = NULL;
+}
+
+void GU_DisplayList::sync(void)
+{
+  if (_gfx != NULL && _n_commands > 0)
+    replay();
+}
+
+// Add a command, bounded by its x/y/w/h. If the list is full, play back
+// what's there to make room.
+GU_DisplayList::GU_Command *GU_DisplayList::record(uint8_t op, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color)
+{
+  GU_Command *c;
+
+  if (_n_commands == GU_DISPLAY_LIST_SIZE)
+    sync();
+  c = &_commands[_n_commands++];
+  c->op = op;
+  c->x = x;
+  c->y = y;
+  c->w = w;
+  c->h = h;
+  c->r = r;
+  c->color = color;
+  c->data = NULL;
+  c->fc = NULL;
+  c->bounds.x1 = x;
+  c->bounds.y1 = y;
+  c->bounds.x2 = x + w;
+  c->bounds.y2 = y + h;
+  c->widget = GU_Stats::getWidget();
+  c->kind = GU_Stats::getKind();
+  _recorded++;
+  return c;
+}
+
+// Record a fill, merging it with the last command if that is a fill of the
+// same color that it extends (such as the next row of a menu).
+void GU_DisplayList::recordFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  GU_Command *last = _n_commands > 0 ? &_commands[_n_commands - 1] : NULL;
+
+  if (w <= 0 || h <= 0)
+    return;
+
+  if (last != NULL && last->op == DL_FILL_RECT && last->color == color
+      && last->widget == GU_Stats::getWidget())
+  {
+    if (last->y == y && last->h == h && (last->x + last->w == x || x + w == last->x))
+    {
+      last->x = min(last->x, x);
+      last->w += w;
+    }
+    else if (last->x == x && last->w == w && (last->y + last->h == y || y + h == last->y))
+    {
+      last->y = min(last->y, y);
+      last->h += h;
+    }
+    else
+    {
+      last = NULL;
+    }
+
+    if (last != NULL)
+    {
+      last->bounds.x1 = last->x;
+      last->bounds.y1 = last->y;
+      last->bounds.x2 = last->x + last->w;
+      last->bounds.y2 = last->y + last->h;
+      return;
+    }
+  }
+  record(DL_FILL_RECT, x, y, w, h, 0, color);
+}
+
+// Copy a label bitmap or string into the list. If there's no room for it, or
+// for the command that will hold it, play back the list to empty it (so that
+// recording the command can't play back the list and reuse the bytes under
+// the copy). Return NULL if it still won't fit; the caller then draws it
+// straight away.
+void *GU_DisplayList::copyData(void *data, int size)
+{
+  void *copy;
+
+  if (_n_commands == GU_DISPLAY_LIST_SIZE || _n_bytes + size > GU_DISPLAY_LIST_BYTES)
+    sync();
+  if (size > GU_DISPLAY_LIST_BYTES)
+    return NULL;
+  copy = &_bytes[_n_bytes];
+  memcpy(copy, data, size);
+  _n_bytes += size;
+  return copy;
+}
+
+void GU_DisplayList::addOccluder(int16_t x1, int16_t y1, int16_t x2, int16_t y2)
+{
+  if (x1 >= x2 || y1 >= y2 || _n_occluders == GU_MAX_OCCLUDERS)
+    return;
+  _occluders[_n_occluders].x1 = x1;
+  _occluders[_n_occluders].y1 = y1;
+  _occluders[_n_occluders].x2 = x2;
+  _occluders[_n_occluders].y2 = y2;
+  _n_occluders++;
+}
+
+// Play back the list. First go through it backwards, collecting the opaque
+// areas (fills, and the middle of rounded fills) and dropping commands that
+// lie entirely inside one drawn after them. Then draw what's left in order.
+void GU_DisplayList::replay(void)
+{
+  Adafruit_GFX *gfx = _gfx;
+  GU_FrameBuffer fb(gfx);
+  void *widget;
+  GU_StatsKind kind;
+
+  _n_occluders = 0;
+  for (int i = _n_commands - 1; i >= 0; i--)
+  {
+    GU_Command *c = &_commands[i];
+
+    c->culled = false;
+    for (int k = 0; k < _n_occluders && !c->culled; k++)
+    {
+      GU_Rect *o = &_occluders[k];
+
+      c->culled = c->bounds.x1 >= o->x1 && c->bounds.x2 <= o->x2
+                  && c->bounds.y1 >= o->y1 && c->bounds.y2 <= o->y2;
+    }
+    if (c->culled)
+    {
+      _culled++;
+      continue;
+    }
+
+    c->n_occluders = _n_occluders;
+    if (c->op == DL_FILL_RECT)
+    {
+      addOccluder(c->x, c->y, c->x + c->w, c->y + c->h);
+    }
+    else if (c->op == DL_FILL_ROUND_RECT)
+    {
+      int16_t r = min(c->r, (int16_t)(min(c->w, c->h) / 2));
+
+      addOccluder(c->x + r, c->y, c->x + c->w - r, c->y + c->h);
+      addOccluder(c->x, c->y + r, c->x + c->w, c->y + c->h - r);
+    }
+  }
+
+  // Draw for real (the frame buffer calls check whether we are recording).
+  // Each command's writes are counted against the element that recorded it,
+  // then the element drawing now gets its own back.
+  widget = GU_Stats::getWidget();
+  kind = GU_Stats::getKind();
+  _gfx = NULL;
+  for (int i = 0; i < _n_commands; i++)
+  {
+    GU_Command *c = &_commands[i];
+
+    if (c->culled)
+      continue;
+    GU_Stats::setWidget(c->widget, (GU_StatsKind)c->kind);
+    switch (c->op)
+    {
+    case DL_FILL_RECT:
+      fillAround(&fb, c);
+      break;
+    case DL_FILL_ROUND_RECT:
+      fb.fillRoundRect(c->x, c->y, c->w, c->h, c->r, c->color);
+      break;
+    case DL_DRAW_ROUND_RECT:
+      fb.drawRoundRect(c->x, c->y, c->w, c->h, c->r, c->color);
+      break;
+    case DL_FILL_CIRCLE:
+      fb.fillCircle(c->x + c->r, c->y + c->r, c->r, c->color);
+      break;
+    case DL_DRAW_CIRCLE:
+      fb.drawCircle(c->x + c->r, c->y + c->r, c->r, c->color);
+      break;
+    case DL_BITS:
+      fb.drawBits(c->x, c->y, c->w, c->h, (uint8_t *)c->data, c->color);
+      break;
+    case DL_TEXT:
+      fb.drawText(c->fc, (char *)c->data, c->x, c->y, c->color, c->textsize);
+      break;
+    }
+  }
+  _gfx = gfx;
+  GU_Stats::setWidget(widget, kind);
+  _n_commands = 0;
+  _n_bytes = 0;
+}
+
+// Fill a rectangle, leaving out the parts that opaque fills drawn later will
+// cover. The rectangle is cut into bands at the tops and bottoms of those
+// fills; within a band, the gaps between them are filled.
+void GU_DisplayList::fillAround(GU_FrameBuffer *fb, GU_Command *c)
+{
+  GU_Rect over[GU_MAX_OCCLUDERS];
+  int16_t ys[2 * GU_MAX_OCCLUDERS + 2];
+  int n_over = 0;
+  int n_ys = 0;
+
+  // The later fills that overlap this one, clipped to it
+  for (int k = 0; k < c->n_occluders; k++)
+  {
+    GU_Rect o = _occluders[k];
+
+    o.x1 = max(o.x1, c->bounds.x1);
+    o.y1 = max(o.y1, c->bounds.y1);
+    o.x2 = min(o.x2, c->bounds.x2);
+    o.y2 = min(o.y2, c->bounds.y2);
+    if (o.x1 < o.x2 && o.y1 < o.y2)
+      over[n_over++] = o;
+  }
+  if (n_over == 0)
+  {
+    fb->fillRect(c->x, c->y, c->w, c->h, c->color);
+    return;
+  }
+
+  // Band edges, sorted
+  ys[n_ys++] = c->bounds.y1;
+  ys[n_ys++] = c->bounds.y2;
+  for (int k = 0; k < n_over; k++)
+  {
+    ys[n_ys++] = over[k].y1;
+    ys[n_ys++] = over[k].y2;
+  }
+  for (int i = 1; i < n_ys; i++)
+  {
+    int16_t y = ys[i];
+    int j;
+
+    for (j = i; j > 0 && ys[j - 1] > y; j--)
+      ys[j] = ys[j - 1];
+    ys[j] = y;
+  }
+
+  for (int b = 0; b + 1 < n_ys; b++)
+  {
+    int16_t y1 = ys[b];
+    int16_t y2 = ys[b + 1];
+    int16_t x;
+    int16_t x1s[GU_MAX_OCCLUDERS], x2s[GU_MAX_OCCLUDERS];
+    int n = 0;
+
+    if (y1 == y2)
+      continue;
+
+    // Fills covering this band, sorted by their left edge
+    for (int k = 0; k < n_over; k++)
+    {
+      int j;
+
+      if (over[k].y1 > y1 || over[k].y2 < y2)
+        continue;
+      for (j = n; j > 0 && x1s[j - 1] > over[k].x1; j--)
+      {
+        x1s[j] = x1s[j - 1];
+        x2s[j] = x2s[j - 1];
+      }
+      x1s[j] = over[k].x1;
+      x2s[j] = over[k].x2;
+      n++;
+    }
+
+    // Fill the gaps between them
+    x = c->bounds.x1;
+    for (int k = 0; k < n; k++)
+    {
+      if (x1s[k] > x)
+        fb->fillRect(x, y1, x1s[k] - x, y2 - y1, c->color);
+      x = max(x, x2s[k]);
+    }
+    if (x < c->bounds.x2)
+      fb->fillRect(x, y1, c->bounds.x2 - x, y2 - y1, c->color);
+  }
+}
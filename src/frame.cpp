@@ -0,0 +1,113 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+
+// Frame scheduler.
+
+bool GU_Frame::_deferred = false;
+unsigned long GU_Frame::_frame_ms = 1000 / GU_FRAME_RATE;
+unsigned long GU_Frame::_last_frame = 0;
+GU_Frame::GU_Dirty GU_Frame::_dirty[GU_FRAME_MAX_DIRTY];
+int GU_Frame::_n_dirty = 0;
+GU_Frame::GU_Animation GU_Frame::_anim[GU_FRAME_MAX_ANIMATIONS];
+int GU_Frame::_n_anim = 0;
+
+// Going back to drawing straight away draws anything still waiting.
+void GU_Frame::setDeferred(bool deferred)
+{
+  _deferred = deferred;
+  if (!deferred)
+    flush();
+}
+
+void GU_Frame::invalidate(void *element, RedrawCB redraw)
+{
+  if (!_deferred)
+  {
+    (*redraw)(element);
+    return;
+  }
+
+  for (int i = 0; i < _n_dirty; i++)
+  {
+    if (_dirty[i].element == element)
+      return;
+  }
+
+  // If the list is full, draw what's on it to make room.
+  if (_n_dirty == GU_FRAME_MAX_DIRTY)
+    flush();
+  _dirty[_n_dirty].element = element;
+  _dirty[_n_dirty].redraw = redraw;
+  _n_dirty++;
+}
+
+void GU_Frame::validate(void *element)
+{
+  for (int i = 0; i < _n_dirty; i++)
+  {
+    if (_dirty[i].element == element)
+    {
+      _n_dirty--;
+      memmove(&_dirty[i], &_dirty[i + 1], (_n_dirty - i) * sizeof(GU_Dirty));
+      return;
+    }
+  }
+}
+
+bool GU_Frame::animate(void *element, AnimateCB step)
+{
+  stopAnimation(element);
+  if (_n_anim == GU_FRAME_MAX_ANIMATIONS)
+    return false;
+  _anim[_n_anim].element = element;
+  _anim[_n_anim].step = step;
+  _n_anim++;
+  return true;
+}
+
+void GU_Frame::stopAnimation(void *element)
+{
+  for (int i = 0; i < _n_anim; i++)
+  {
+    if (_anim[i].element == element)
+    {
+      _n_anim--;
+      memmove(&_anim[i], &_anim[i + 1], (_n_anim - i) * sizeof(GU_Animation));
+      return;
+    }
+  }
+}
+
+// Step the animations, then draw what's invalid. A step may stop or start
+// animations (its own included), so each is looked for again after it.
+bool GU_Frame::tick(void)
+{
+  if ((_n_dirty == 0 && _n_anim == 0) || GU_Trace::now() - _last_frame < _frame_ms)
+    return false;
+
+  for (int i = 0; i < _n_anim; )
+  {
+    GU_Animation a = _anim[i];
+
+    if (!(*a.step)(a.element))
+      stopAnimation(a.element);
+    if (i < _n_anim && _anim[i].element == a.element)
+      i++;
+  }
+  flush();
+  return true;
+}
+
+// Draw the elements in the order they were invalidated. Each one takes itself
+// off the list as it is drawn, so take them from the front.
+void GU_Frame::flush(void)
+{
+  _last_frame = GU_Trace::now();
+  while (_n_dirty > 0)
+  {
+    GU_Dirty d = _dirty[0];
+
+    validate(d.element);
+    (*d.redraw)(d.element);
+  }
+}
@@ -0,0 +1,799 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+#include <SDRAM.h>
+
+// Frame buffer access.
+
+GU_FrameBuffer::GU_SpanTable GU_FrameBuffer::_tables[GU_SPAN_TABLES];
+int GU_FrameBuffer::_n_tables = 0;
+int GU_FrameBuffer::_next_table = 0;
+GU_Surface *GU_Surface::_surfaces = NULL;
+
+// Work out the address of pixel (0, 0) and the steps along rotated X and Y.
+// These mirror the rotation in GigaDisplay_GFX::drawPixel (and in
+// GFXcanvas16::drawPixel, which does the same).
+GU_FrameBuffer::GU_FrameBuffer(Adafruit_GFX *gfx)
+{
+  GU_Surface *surface = GU_Surface::find(gfx);
+  uint16_t *base;
+  int raw_w, raw_h;
+
+  if (surface != NULL)
+    base = surface->getBuffer();
+  else
+    base = ((GigaDisplay_GFX *)gfx)->getBuffer();
+
+  _gfx = gfx;
+  if (gfx->getRotation() & 1)
+  {
+    raw_w = gfx->height();
+    raw_h = gfx->width();
+  }
+  else
+  {
+    raw_w = gfx->width();
+    raw_h = gfx->height();
+  }
+
+  switch (gfx->getRotation())
+  {
+  case 0:
+  default:
+    _origin = base;
+    _xstep = 1;
+    _ystep = raw_w;
+    break;
+  case 1:
+    _origin = base + raw_w - 1;
+    _xstep = raw_w;
+    _ystep = -1;
+    break;
+  case 2:
+    _origin = base + raw_w * raw_h - 1;
+    _xstep = -1;
+    _ystep = -raw_w;
+    break;
+  case 3:
+    _origin = base + (raw_h - 1) * raw_w;
+    _xstep = -raw_w;
+    _ystep = 1;
+    break;
+  }
+  if (base == NULL)
+    _origin = NULL;
+  _base = base;
+  _counting = base != NULL && GU_Stats::isCounting(gfx);
+}
+
+// Copy a rectangle of the screen to a buffer.
+void GU_FrameBuffer::readRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *pixels)
+{
+  if (GU_DisplayList::isRecording(_gfx))
+    GU_DisplayList::sync();
+  if (!isValid())
+    return;
+
+  for (int16_t j = 0; j < h; j++)
+  {
+    uint16_t *p = pixelAddr(x, y + j);
+
+    if (_xstep == 1)
+    {
+      memcpy(pixels, p, w * sizeof(uint16_t));
+      pixels += w;
+    }
+    else
+    {
+      for (int16_t i = 0; i < w; i++, p += _xstep)
+        *pixels++ = *p;
+    }
+  }
+}
+
+// Copy a buffer back to a rectangle of the screen. The write is bracketed with
+// startWrite/endWrite so the display knows the buffer has changed.
+void GU_FrameBuffer::writeRect(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t *pixels, uint16_t stride)
+{
+  if (GU_DisplayList::isRecording(_gfx))
+    GU_DisplayList::sync();
+  if (!isValid())
+    return;
+
+  if (stride == 0)
+    stride = w;
+  _gfx->startWrite();
+  for (int16_t j = 0; j < h; j++)
+  {
+    uint16_t *p = pixelAddr(x, y + j);
+
+    if (_counting)
+      GU_Stats::countPixels(p, w, _xstep);
+    if (_xstep == 1)
+    {
+      memcpy(p, pixels, w * sizeof(uint16_t));
+    }
+    else
+    {
+      for (int16_t i = 0; i < w; i++, p += _xstep)
+        *p = pixels[i];
+    }
+    pixels += stride;
+  }
+  _gfx->endWrite();
+}
+
+// Move a rectangle. Depending on the rotation, either rows or columns are
+// contiguous in memory, so copy whichever they are with memmove. Rows (or
+// columns) are copied in an order that doesn't overwrite any before they
+// have been copied themselves.
+void GU_FrameBuffer::moveRect(int16_t x, int16_t y, uint16_t w, uint16_t h, int16_t dx, int16_t dy)
+{
+  if (GU_DisplayList::isRecording(_gfx))
+    GU_DisplayList::sync();
+  if (!isValid() || w == 0 || h == 0)
+    return;
+
+  _gfx->startWrite();
+  if (_ystep == 1 || _ystep == -1)
+  {
+    for (int16_t n = 0; n < w; n++)
+    {
+      int16_t i = dx > 0 ? w - 1 - n : n;
+      uint16_t *src = pixelAddr(x + i, y + (_ystep < 0 ? h - 1 : 0));
+      uint16_t *dst = pixelAddr(x + i + dx, y + dy + (_ystep < 0 ? h - 1 : 0));
+
+      if (_counting)
+        GU_Stats::countPixels(dst, h, 1);
+      memmove(dst, src, h * sizeof(uint16_t));
+    }
+  }
+  else
+  {
+    for (int16_t n = 0; n < h; n++)
+    {
+      int16_t j = dy > 0 ? h - 1 - n : n;
+      uint16_t *src = pixelAddr(x + (_xstep < 0 ? w - 1 : 0), y + j);
+      uint16_t *dst = pixelAddr(x + dx + (_xstep < 0 ? w - 1 : 0), y + j + dy);
+
+      if (_counting)
+        GU_Stats::countPixels(dst, w, 1);
+      memmove(dst, src, w * sizeof(uint16_t));
+    }
+  }
+  _gfx->endWrite();
+}
+
+// Draw the set bits of a 1-bit bitmap, clipping it to the screen.
+void GU_FrameBuffer::drawBits(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t *bits, uint16_t color)
+{
+  if (GU_DisplayList::isRecording(_gfx))
+  {
+    void *copy = GU_DisplayList::copyData(bits, (w + 7) / 8 * h);
+
+    if (copy != NULL)
+    {
+      GU_DisplayList::record(GU_DisplayList::DL_BITS, x, y, w, h, 0, color)->data = copy;
+      return;
+    }
+  }
+  blitBits(x, y, w, h, bits, color, true);
+}
+
+// Go through the set bits of a bitmap that are on the screen, drawing them,
+// and/or counting them if GU_Stats is counting.
+void GU_FrameBuffer::blitBits(int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t *bits, uint16_t color, bool draw)
+{
+  int16_t i0 = max(0, -x);
+  int16_t i1 = min((int)w, _gfx->width() - x);
+  int16_t j0 = max(0, -y);
+  int16_t j1 = min((int)h, _gfx->height() - y);
+  uint16_t bytes_per_row = (w + 7) / 8;
+
+  if (!isValid() || i0 >= i1 || j0 >= j1)
+    return;
+
+  if (draw)
+    _gfx->startWrite();
+  for (int16_t j = j0; j < j1; j++)
+  {
+    uint8_t *row = bits + j * bytes_per_row;
+    uint16_t *p = pixelAddr(x + i0, y + j);
+
+    for (int16_t i = i0; i < i1; i++, p += _xstep)
+    {
+      // Skip whole bytes with nothing set (most of a label is background)
+      if ((i & 7) == 0 && row[i >> 3] == 0 && i + 8 <= i1)
+      {
+        i += 7;
+        p += 7 * _xstep;
+        continue;
+      }
+      if (row[i >> 3] & (0x80 >> (i & 7)))
+      {
+        if (_counting)
+          GU_Stats::countPixels(p, 1, 0);
+        if (draw)
+          *p = color;
+      }
+    }
+  }
+  if (draw)
+    _gfx->endWrite();
+}
+
+// Write a clipped horizontal span from x1 to x2 inclusive.
+// The caller brackets it with startWrite/endWrite.
+void GU_FrameBuffer::span(int16_t x1, int16_t x2, int16_t y, uint16_t color)
+{
+  if (y < 0 || y >= _gfx->height())
+    return;
+  x1 = max(x1, (int16_t)0);
+  x2 = min(x2, (int16_t)(_gfx->width() - 1));
+  if (x1 > x2)
+    return;
+
+  uint16_t *p = pixelAddr(x1, y);
+  int n = x2 - x1 + 1;
+
+  if (_counting)
+    GU_Stats::countPixels(p, n, _xstep);
+  if (_xstep == 1)
+  {
+    while (n-- > 0)
+      *p++ = color;
+  }
+  else
+  {
+    for (; n > 0; n--, p += _xstep)
+      *p = color;
+  }
+}
+
+void GU_FrameBuffer::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+  if (GU_DisplayList::isRecording(_gfx))
+  {
+    GU_DisplayList::recordFill(x, y, w, 1, color);
+    return;
+  }
+  if (!isValid())
+  {
+    _gfx->drawFastHLine(x, y, w, color);
+    return;
+  }
+  _gfx->startWrite();
+  span(x, x + w - 1, y, color);
+  _gfx->endWrite();
+}
+
+void GU_FrameBuffer::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+  fillRect(x, y, 1, h, color);
+}
+
+// Fill a rectangle, along whichever of rows or columns is contiguous in memory.
+void GU_FrameBuffer::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  if (GU_DisplayList::isRecording(_gfx))
+  {
+    GU_DisplayList::recordFill(x, y, w, h, color);
+    return;
+  }
+  if (!isValid())
+  {
+    _gfx->fillRect(x, y, w, h, color);
+    return;
+  }
+
+  int16_t x1 = max(x, (int16_t)0);
+  int16_t x2 = min((int16_t)(x + w), _gfx->width());
+  int16_t y1 = max(y, (int16_t)0);
+  int16_t y2 = min((int16_t)(y + h), _gfx->height());
+
+  if (x1 >= x2 || y1 >= y2)
+    return;
+
+  _gfx->startWrite();
+  if (_ystep == 1 || _ystep == -1)
+  {
+    for (int16_t i = x1; i < x2; i++)
+    {
+      uint16_t *p = pixelAddr(i, _ystep < 0 ? y2 - 1 : y1);
+
+      if (_counting)
+        GU_Stats::countPixels(p, y2 - y1, 1);
+      for (int16_t n = y2 - y1; n > 0; n--)
+        *p++ = color;
+    }
+  }
+  else
+  {
+    for (int16_t j = y1; j < y2; j++)
+      span(x1, x2 - 1, j, color);
+  }
+  _gfx->endWrite();
+}
+
+void GU_FrameBuffer::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  drawFastHLine(x, y, w, color);
+  drawFastHLine(x, y + h - 1, w, color);
+  drawFastVLine(x, y, h, color);
+  drawFastVLine(x + w - 1, y, h, color);
+}
+
+// Find the span table for a radius, computing it if it's not there.
+// The tables are worked out by following the Adafruit_GFX circle helpers
+// and noting the pixels they would draw. Return NULL if the radius is
+// too big for a table.
+GU_FrameBuffer::GU_SpanTable *GU_FrameBuffer::spanTable(int16_t r)
+{
+  GU_SpanTable *t;
+  int16_t e[GU_SPAN_MAX_RADIUS + 1];    // half height of each column of a filled circle
+  int16_t f, ddF_x, ddF_y, x, y, px, py;
+
+  if (r < 0 || r > GU_SPAN_MAX_RADIUS)
+    return NULL;
+  for (int i = 0; i < _n_tables; i++)
+  {
+    if (_tables[i].r == r)
+      return &_tables[i];
+  }
+
+  // Use the next empty table, or replace the oldest.
+  t = &_tables[_next_table];
+  _next_table = (_next_table + 1) % GU_SPAN_TABLES;
+  if (_n_tables < GU_SPAN_TABLES)
+    _n_tables++;
+
+  // Filled: the columns drawn by fillCircleHelper (and the centre column).
+  e[0] = r;
+  for (int c = 1; c <= r; c++)
+    e[c] = -1;
+  f = 1 - r;
+  ddF_x = 1;
+  ddF_y = -2 * r;
+  x = 0;
+  y = r;
+  px = x;
+  py = y;
+  while (x < y)
+  {
+    if (f >= 0)
+    {
+      y--;
+      ddF_y += 2;
+      f += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f += ddF_x;
+    if (x < y + 1)
+      e[x] = max(e[x], y);
+    if (y != py)
+    {
+      e[py] = max(e[py], px);
+      py = y;
+    }
+    px = x;
+  }
+  for (int b = 0; b <= r; b++)
+  {
+    t->fill[b] = 0;
+    for (int c = 0; c <= r; c++)
+    {
+      if (e[c] >= b)
+        t->fill[b] = c;
+    }
+  }
+
+  // Outline: the pixels drawn by drawCircleHelper, in one quadrant.
+  for (int b = 0; b <= r; b++)
+  {
+    t->lo[b] = 255;
+    t->hi[b] = 0;
+  }
+  f = 1 - r;
+  ddF_x = 1;
+  ddF_y = -2 * r;
+  x = 0;
+  y = r;
+  while (x < y)
+  {
+    if (f >= 0)
+    {
+      y--;
+      ddF_y += 2;
+      f += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f += ddF_x;
+    t->lo[y] = min(t->lo[y], (uint8_t)x);
+    t->hi[y] = max(t->hi[y], (uint8_t)x);
+    t->lo[x] = min(t->lo[x], (uint8_t)y);
+    t->hi[x] = max(t->hi[x], (uint8_t)y);
+  }
+
+  t->r = r;
+  return t;
+}
+
+// Draw the outline spans of one quadrant about x0/y0.
+void GU_FrameBuffer::cornerSpans(GU_SpanTable *t, int16_t x0, int16_t y0, bool left, bool top, uint16_t color)
+{
+  for (int16_t b = 0; b <= t->r; b++)
+  {
+    int16_t y = top ? y0 - b : y0 + b;
+
+    if (t->lo[b] > t->hi[b])
+      continue;
+    if (left)
+      span(x0 - t->hi[b], x0 - t->lo[b], y, color);
+    else
+      span(x0 + t->lo[b], x0 + t->hi[b], y, color);
+  }
+}
+
+// Rounded rectangles. Each row is one span, narrowed at the corners.
+void GU_FrameBuffer::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color)
+{
+  int16_t max_radius = min(w, h) / 2;
+  GU_SpanTable *t;
+
+  if (GU_DisplayList::isRecording(_gfx))
+  {
+    GU_DisplayList::record(GU_DisplayList::DL_FILL_ROUND_RECT, x, y, w, h, r, color);
+    return;
+  }
+  if (r > max_radius)
+    r = max_radius;
+  t = spanTable(r);
+  if (!isValid() || t == NULL)
+  {
+    _gfx->fillRoundRect(x, y, w, h, r, color);
+    return;
+  }
+
+  _gfx->startWrite();
+  for (int16_t i = 0; i < h; i++)
+  {
+    // Rows into the top or bottom corners
+    int16_t b = max(r - i, i - (h - 1 - r));
+    int16_t m = t->fill[max(b, (int16_t)0)];
+
+    span(x + r - m, x + w - r - 1 + m, y + i, color);
+  }
+  _gfx->endWrite();
+}
+
+void GU_FrameBuffer::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color)
+{
+  int16_t max_radius = min(w, h) / 2;
+  GU_SpanTable *t;
+
+  if (GU_DisplayList::isRecording(_gfx))
+  {
+    GU_DisplayList::record(GU_DisplayList::DL_DRAW_ROUND_RECT, x, y, w, h, r, color);
+    return;
+  }
+  if (r > max_radius)
+    r = max_radius;
+  t = spanTable(r);
+  if (!isValid() || t == NULL)
+  {
+    _gfx->drawRoundRect(x, y, w, h, r, color);
+    return;
+  }
+
+  drawFastHLine(x + r, y, w - 2 * r, color);
+  drawFastHLine(x + r, y + h - 1, w - 2 * r, color);
+  drawFastVLine(x, y + r, h - 2 * r, color);
+  drawFastVLine(x + w - 1, y + r, h - 2 * r, color);
+  _gfx->startWrite();
+  cornerSpans(t, x + r, y + r, true, true, color);
+  cornerSpans(t, x + w - r - 1, y + r, false, true, color);
+  cornerSpans(t, x + w - r - 1, y + h - r - 1, false, false, color);
+  cornerSpans(t, x + r, y + h - r - 1, true, false, color);
+  _gfx->endWrite();
+}
+
+// Circles.
+void GU_FrameBuffer::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+  GU_SpanTable *t;
+
+  if (GU_DisplayList::isRecording(_gfx))
+  {
+    GU_DisplayList::record(GU_DisplayList::DL_FILL_CIRCLE, x0 - r, y0 - r, 2 * r + 1, 2 * r + 1, r, color);
+    return;
+  }
+  t = spanTable(r);
+  if (!isValid() || t == NULL)
+  {
+    _gfx->fillCircle(x0, y0, r, color);
+    return;
+  }
+
+  _gfx->startWrite();
+  for (int16_t b = -r; b <= r; b++)
+  {
+    int16_t m = t->fill[abs(b)];
+
+    span(x0 - m, x0 + m, y0 + b, color);
+  }
+  _gfx->endWrite();
+}
+
+void GU_FrameBuffer::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+  GU_SpanTable *t;
+
+  if (GU_DisplayList::isRecording(_gfx))
+  {
+    GU_DisplayList::record(GU_DisplayList::DL_DRAW_CIRCLE, x0 - r, y0 - r, 2 * r + 1, 2 * r + 1, r, color);
+    return;
+  }
+  t = spanTable(r);
+  if (!isValid() || t == NULL)
+  {
+    _gfx->drawCircle(x0, y0, r, color);
+    return;
+  }
+
+  _gfx->startWrite();
+  span(x0, x0, y0 - r, color);
+  span(x0, x0, y0 + r, color);
+  span(x0 - r, x0 - r, y0, color);
+  span(x0 + r, x0 + r, y0, color);
+  cornerSpans(t, x0, y0, true, true, color);
+  cornerSpans(t, x0, y0, false, true, color);
+  cornerSpans(t, x0, y0, false, false, color);
+  cornerSpans(t, x0, y0, true, false, color);
+  _gfx->endWrite();
+}
+
+// Blend a color into a rectangle, along whichever of rows or columns is
+// contiguous in memory. This reads the screen, so anything recorded is
+// drawn first.
+void GU_FrameBuffer::blendRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color, uint8_t alpha)
+{
+  if (GU_DisplayList::isRecording(_gfx))
+    GU_DisplayList::sync();
+  if (!isValid() || alpha == 0)
+    return;
+
+  int16_t x1 = max(x, (int16_t)0);
+  int16_t x2 = min((int16_t)(x + w), _gfx->width());
+  int16_t y1 = max(y, (int16_t)0);
+  int16_t y2 = min((int16_t)(y + h), _gfx->height());
+  bool columns = _ystep == 1 || _ystep == -1;
+  int16_t lines = columns ? x2 - x1 : y2 - y1;
+  int16_t n = columns ? y2 - y1 : x2 - x1;
+
+  if (x1 >= x2 || y1 >= y2)
+    return;
+
+  _gfx->startWrite();
+  for (int16_t k = 0; k < lines; k++)
+  {
+    uint16_t *p;
+
+    if (columns)
+      p = pixelAddr(x1 + k, _ystep < 0 ? y2 - 1 : y1);
+    else
+      p = pixelAddr(_xstep < 0 ? x2 - 1 : x1, y1 + k);
+    if (_counting)
+      GU_Stats::countPixels(p, n, 1);
+    if (color == BLACK)
+      rgb565_darken_span(p, n, alpha);
+    else
+      rgb565_mix_span(p, n, color, alpha);
+  }
+  _gfx->endWrite();
+}
+
+// Text. When recording, the text is copied, and bounded by its metrics.
+void GU_FrameBuffer::drawText(FontCollection *fc, char *str, int16_t x, int16_t y, uint16_t color, uint8_t textsize)
+{
+  if (GU_DisplayList::isRecording(_gfx))
+  {
+    void *copy = GU_DisplayList::copyData(str, strlen(str) + 1);
+
+    if (copy != NULL)
+    {
+      GU_TextBounds b;
+      GU_DisplayList::GU_Command *c;
+
+      GU_TextMetrics::getTextBounds(fc, str, textsize, &b);
+      c = GU_DisplayList::record(GU_DisplayList::DL_TEXT, x + b.x, y + b.y, b.w, b.h, 0, color);
+      c->x = x;
+      c->y = y;
+      c->data = copy;
+      c->fc = fc;
+      c->textsize = textsize;
+      return;
+    }
+  }
+
+  // To count the pixels of the text, draw it off-screen and count the bits.
+  if (_counting)
+  {
+    GU_TextBounds b;
+    uint8_t *bits;
+
+    GU_TextMetrics::getTextBounds(fc, str, textsize, &b);
+    bits = (uint8_t *)calloc((b.w + 7) / 8 * b.h, 1);
+    if (bits != NULL)
+    {
+      rasterizeText(fc, str, textsize, -b.x, -b.y, b.w, b.h, bits);
+      blitBits(x + b.x, y + b.y, b.w, b.h, bits, color, false);
+      free(bits);
+    }
+  }
+  fc->drawText(str, x, y, color, textsize);
+}
+
+// Point the font collection at an off-screen 1-bit canvas while drawing
+// the text, then put it back.
+void GU_FrameBuffer::rasterizeText(FontCollection *fc, char *str, uint8_t textsize,
+                                   int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t *bits)
+{
+  GU_BitSurface canvas(w, h);
+  Adafruit_GFX *gfx = fc->_gfx;
+
+  canvas.setBits(bits);
+  canvas.setTextWrap(false);
+  fc->_gfx = &canvas;
+  fc->drawText(str, x, y, 1, textsize);
+  fc->_gfx = gfx;
+}
+
+// Surfaces are kept in a list. There are only ever one or two.
+GU_Surface::GU_Surface(uint16_t w, uint16_t h) : GFXcanvas16(w, h, false)
+{
+  _next = _surfaces;
+  _surfaces = this;
+}
+
+GU_Surface::~GU_Surface()
+{
+  GU_Surface **s;
+
+  for (s = &_surfaces; *s != NULL; s = &(*s)->_next)
+  {
+    if (*s == this)
+    {
+      *s = _next;
+      break;
+    }
+  }
+  buffer = NULL;    // don't let the canvas free it
+}
+
+GU_Surface *GU_Surface::find(Adafruit_GFX *gfx)
+{
+  for (GU_Surface *s = _surfaces; s != NULL; s = s->_next)
+  {
+    if ((Adafruit_GFX *)s == gfx)
+      return s;
+  }
+  return NULL;
+}
+
+// Pixel buffers live in SDRAM (already started by the display).
+uint16_t *GU_FrameBuffer::allocPixels(uint32_t n_pixels)
+{
+  return (uint16_t *)SDRAM.malloc(n_pixels * sizeof(uint16_t));
+}
+
+void GU_FrameBuffer::freePixels(uint16_t *pixels)
+{
+  if (pixels != NULL)
+    SDRAM.free(pixels);
+}
+
+// Little-endian helpers for the BMP header.
+static void put16(uint8_t *p, uint16_t v)
+{
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+  put16(p, v & 0xFFFF);
+  put16(p + 2, v >> 16);
+}
+
+// Write the header of a w x h BMP with RGB565 (BI_BITFIELDS) pixels, stored
+// top-down. Return the number of bytes in each row (rows are padded to 4 bytes).
+uint32_t GU_FrameBuffer::writeBMPHeader(Print *out, uint16_t w, uint16_t h)
+{
+  uint8_t hdr[66];
+  uint32_t row_bytes = (w * 2 + 3) & ~3;
+  uint32_t image_bytes = row_bytes * h;
+
+  memset(hdr, 0, sizeof(hdr));
+  hdr[0] = 'B';
+  hdr[1] = 'M';
+  put32(&hdr[2], sizeof(hdr) + image_bytes);  // file size
+  put32(&hdr[10], sizeof(hdr));               // offset to pixels
+  put32(&hdr[14], 40);                        // BITMAPINFOHEADER
+  put32(&hdr[18], w);
+  put32(&hdr[22], -(int32_t)h);               // negative height = top-down
+  put16(&hdr[26], 1);                         // planes
+  put16(&hdr[28], 16);                        // bits per pixel
+  put32(&hdr[30], 3);                         // BI_BITFIELDS
+  put32(&hdr[34], image_bytes);
+  put32(&hdr[38], 2835);                      // 72 dpi
+  put32(&hdr[42], 2835);
+  put32(&hdr[54], 0xF800);                    // red, green and blue masks
+  put32(&hdr[58], 0x07E0);
+  put32(&hdr[62], 0x001F);
+  out->write(hdr, sizeof(hdr));
+  return row_bytes;
+}
+
+// Write a rectangle of the screen as a BMP. The pixels are written as RGB565
+// (BI_BITFIELDS) top-down, so no conversion is needed.
+void GU_FrameBuffer::dumpFrame(Print *out, int16_t x, int16_t y, uint16_t w, uint16_t h)
+{
+  uint8_t chunk[64];
+  uint32_t row_bytes;
+
+  if (GU_DisplayList::isRecording(_gfx))
+    GU_DisplayList::sync();
+  if (!isValid())
+    return;
+
+  if (w == 0 || h == 0)
+  {
+    x = 0;
+    y = 0;
+    w = _gfx->width();
+    h = _gfx->height();
+  }
+
+  // Clip to the screen.
+  if (x < 0)
+  {
+    w = max(0, w + x);
+    x = 0;
+  }
+  if (y < 0)
+  {
+    h = max(0, h + y);
+    y = 0;
+  }
+  w = min((int)w, _gfx->width() - x);
+  h = min((int)h, _gfx->height() - y);
+
+  row_bytes = writeBMPHeader(out, w, h);
+
+  // Send each row in small chunks, so we don't need a row buffer.
+  for (int16_t j = 0; j < h; j++)
+  {
+    uint16_t *p = pixelAddr(x, y + j);
+    uint32_t n = 0;
+
+    for (int16_t i = 0; i < w; i++)
+    {
+      put16(&chunk[n], *p);
+      p += _xstep;
+      n += 2;
+      if (n == sizeof(chunk))
+      {
+        out->write(chunk, n);
+        n = 0;
+      }
+    }
+    if (n > 0)
+      out->write(chunk, n);
+    if (row_bytes > w * 2u)
+    {
+      memset(chunk, 0, 2);    // pad odd widths
+      out->write(chunk, 2);
+    }
+  }
+}
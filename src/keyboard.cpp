@@ -0,0 +1,355 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+
+// On-screen keyboard.
+
+// The layouts, a string of keys per row. Keys are 2 half-keys wide, except
+// for these (see key_width).
+static const char *const letters[GU_KEYBOARD_ROWS] =
+{
+  "qwertyuiop",
+  "asdfghjkl",
+  "\x02zxcvbnm\b",
+  "\x01, .\n"
+};
+
+static const char *const symbols[GU_KEYBOARD_ROWS] =
+{
+  "1234567890",
+  "-/:;()$&@\"",
+  "#*+=_?!'\b",
+  "\x01, .\n"
+};
+
+// Width of a key in half-keys. Each row is at most 20 (10 keys).
+static int key_width(char c)
+{
+  switch (c)
+  {
+  case GU_KEY_LAYOUT:
+  case GU_KEY_SHIFT:
+  case GU_KEY_BACKSPACE:
+  case GU_KEY_ENTER:
+    return 3;
+  case ' ':
+    return 10;
+  }
+  return 2;
+}
+
+void GU_Keyboard::initKeyboard(int16_t x1, int16_t y1, uint16_t w, uint16_t h,
+                            uint16_t outline, uint16_t fill,
+                            uint16_t highlight, uint16_t textcolor,
+                            TapCB callback, int indx, void *param, uint8_t textsize)
+{
+  _x1 = x1;
+  _y1 = y1;
+  _w = w;
+  _h = h;
+  _row_h = h / (GU_KEYBOARD_ROWS + 1);
+  _outlinecolor = outline;
+  _fillcolor = fill;
+  _highlightcolor = highlight;
+  _textcolor = textcolor;
+  _textsize = textsize;
+  _callback = callback;
+  _indx = indx;
+  _param = param;
+
+  _symbols = false;
+  _shift = false;
+  _pressed = -1;
+  _text[0] = '\0';
+  _len = 0;
+  layout();
+  drawKeyboard();
+
+  // One tap covers the keys; hitTest finds which one.
+  _gd->onTap(_x1, _y1 + _row_h, _w, _row_h * GU_KEYBOARD_ROWS, keyboard_tap_wrapper, _indx, (void *)this);
+}
+
+void GU_Keyboard::destroyKeyboard(void)
+{
+  _gd->cancelEvent(_indx);
+  _pressed = -1;
+}
+
+// Work out where the keys of the current layout go. Rows are centred.
+void GU_Keyboard::layout(void)
+{
+  uint16_t half = _w / 20;
+
+  _rows = _symbols ? symbols : letters;
+  for (int r = 0; r < GU_KEYBOARD_ROWS; r++)
+  {
+    const char *keys = _rows[r];
+    int n = strlen(keys);
+    int row_w = 0;
+    int16_t x;
+
+    for (int k = 0; k < n; k++)
+      row_w += key_width(keys[k]);
+    x = _x1 + (_w - row_w * half) / 2;
+    for (int k = 0; k < n; k++)
+    {
+      _key_x[r][k] = x;
+      x += key_width(keys[k]) * half;
+    }
+    _key_x[r][n] = x;
+  }
+}
+
+// Find the key under x/y, or -1 if there isn't one (between the ends of a
+// short row and the edges).
+int GU_Keyboard::hitTest(int x, int y)
+{
+  int r = (y - _y1) / _row_h - 1;
+  int n;
+
+  if (y < _y1 || r < 0 || r >= GU_KEYBOARD_ROWS)
+    return -1;
+  n = strlen(_rows[r]);
+  for (int k = 0; k < n; k++)
+  {
+    if (x >= _key_x[r][k] && x < _key_x[r][k + 1])
+      return r * GU_KEYBOARD_COLS + k;
+  }
+  return -1;
+}
+
+// The character a key types (or its special key code).
+char GU_Keyboard::keyChar(int key)
+{
+  char c = _rows[key / GU_KEYBOARD_COLS][key % GU_KEYBOARD_COLS];
+
+  if (_shift && c >= 'a' && c <= 'z')
+    c += 'A' - 'a';
+  return c;
+}
+
+// Draw a key, highlighted if it's pressed (or it's the shift key and we're shifted).
+void GU_Keyboard::drawKey(int key, bool pressed)
+{
+  int r = key / GU_KEYBOARD_COLS;
+  int k = key % GU_KEYBOARD_COLS;
+  char c = keyChar(key);
+  char label[4] = {c, 0};
+  int16_t x = _key_x[r][k] + 1;
+  int16_t y = _y1 + (r + 1) * _row_h + 1;
+  uint16_t w = _key_x[r][k + 1] - _key_x[r][k] - 2;
+  uint16_t h = _row_h - 2;
+  uint8_t radius = min(w, h) / 4;
+  GU_TextBounds bounds;
+  GU_FrameBuffer fb(_gfx);
+
+  GU_Stats::setWidget(this, GU_STATS_KEYBOARD);
+  if (pressed || (c == GU_KEY_SHIFT && _shift))
+    fb.fillRoundRect(x, y, w, h, radius, _highlightcolor);
+  else
+    fb.fillRoundRect(x, y, w, h, radius, _fillcolor);
+  fb.drawRoundRect(x, y, w, h, radius, _outlinecolor);
+
+  switch (c)
+  {
+  case GU_KEY_LAYOUT:
+    strcpy(label, _symbols ? "abc" : "123");
+    break;
+  case GU_KEY_SHIFT:
+    label[0] = (char)13;    // solid up arrow
+    break;
+  case GU_KEY_BACKSPACE:
+    strcpy(label, "Del");
+    break;
+  case GU_KEY_ENTER:
+    strcpy(label, "OK");
+    break;
+  case ' ':
+    return;
+  }
+
+  GU_TextMetrics::getTextBounds(_fc, label, _textsize, &bounds);
+  fb.drawText(_fc, label, x + (w / 2) - (bounds.w / 2) - bounds.x,
+              y + (h / 2) - (bounds.h / 2) - bounds.y, _textcolor, _textsize);
+}
+
+void GU_Keyboard::drawKeys(void)
+{
+  for (int r = 0; r < GU_KEYBOARD_ROWS; r++)
+  {
+    int n = strlen(_rows[r]);
+
+    for (int k = 0; k < n; k++)
+      drawKey(r * GU_KEYBOARD_COLS + k, false);
+  }
+}
+
+// Draw the field and all of the text. The baseline is placed as for a
+// button, from the bounds of a capital and a descender, so it doesn't move
+// as the text changes.
+void GU_Keyboard::drawField(void)
+{
+  GU_TextBounds bounds;
+  GU_FrameBuffer fb(_gfx);
+
+  GU_Stats::setWidget(this, GU_STATS_KEYBOARD);
+  fb.fillRect(_x1, _y1, _w, _row_h - 1, _fillcolor);
+  fb.drawRect(_x1, _y1, _w, _row_h - 1, _outlinecolor);
+
+  GU_TextMetrics::getTextBounds(_fc, "Ay", _textsize, &bounds);
+  _text_y = _y1 + (_row_h / 2) - (bounds.h / 2) - bounds.y;
+  _char_x[0] = _x1 + bounds.h / 2;
+  for (int i = 0; i < _len; i++)
+    _char_x[i + 1] = _char_x[i] + advance(_text[i]);
+  if (_len > 0)
+    fb.drawText(_fc, _text, _char_x[0], _text_y, _textcolor, _textsize);
+}
+
+void GU_Keyboard::drawKeyboard(void)
+{
+  drawField();
+  drawKeys();
+}
+
+void GU_Keyboard::setText(char *text)
+{
+  _len = 0;
+  _text[0] = '\0';
+  drawField();
+  while (*text != '\0' && addChar(*text))
+    text++;
+}
+
+// How far a character moves the text along. The bounds of two of them are
+// one advance wider than the bounds of one.
+uint16_t GU_Keyboard::advance(char c)
+{
+  char one[2] = {c, 0};
+  char two[3] = {c, c, 0};
+  GU_TextBounds b1, b2;
+
+  GU_TextMetrics::getTextBounds(_fc, one, _textsize, &b1);
+  GU_TextMetrics::getTextBounds(_fc, two, _textsize, &b2);
+  return b2.w - b1.w;
+}
+
+// Add a character to the end of the text and draw just that. Return false if
+// there's no room for it in the text or the field.
+bool GU_Keyboard::addChar(char c)
+{
+  int16_t x = _char_x[_len];
+  uint16_t adv = advance(c);
+  GU_FrameBuffer fb(_gfx);
+
+  if (_len == GU_KEYBOARD_TEXT_LEN - 1 || x + adv > _x1 + _w - (_char_x[0] - _x1))
+    return false;
+
+  GU_Stats::setWidget(this, GU_STATS_KEYBOARD);
+  fb.drawText(_fc, c, x, _text_y, _textcolor, _textsize);
+  _text[_len++] = c;
+  _text[_len] = '\0';
+  _char_x[_len] = x + adv;
+  return true;
+}
+
+// Take the last character off the text, clearing just the area it covered.
+// If it reached back over the one before, draw that one again.
+void GU_Keyboard::deleteChar(void)
+{
+  char c[2];
+  int16_t x1, x2;
+  GU_TextBounds bounds;
+  GU_FrameBuffer fb(_gfx);
+
+  if (_len == 0)
+    return;
+
+  c[0] = _text[--_len];
+  c[1] = '\0';
+  _text[_len] = '\0';
+  GU_TextMetrics::getTextBounds(_fc, c, _textsize, &bounds);
+  x1 = _char_x[_len] + min((int16_t)0, bounds.x);
+  x2 = max(_char_x[_len + 1], (int16_t)(_char_x[_len] + bounds.x + bounds.w));
+  x1 = max(x1, (int16_t)(_x1 + 1));
+  x2 = min(x2, (int16_t)(_x1 + _w - 1));
+
+  GU_Stats::setWidget(this, GU_STATS_KEYBOARD);
+  fb.fillRect(x1, _y1 + 1, x2 - x1, _row_h - 3, _fillcolor);
+  if (bounds.x < 0 && _len > 0)
+    fb.drawText(_fc, _text[_len - 1], _char_x[_len - 1], _text_y, _textcolor, _textsize);
+}
+
+// Highlight a key as it's pressed. When it's released, put it back and act on it.
+void GU_Keyboard::keyboard_tap_cb(EventType ev, int indx, void *param, int x, int y)
+{
+  int key;
+  char c;
+
+  if (!(ev & EV_RELEASED))
+  {
+    if (_pressed >= 0)
+      drawKey(_pressed, false);
+    _pressed = hitTest(x, y);
+    if (_pressed >= 0)
+      drawKey(_pressed, true);
+    return;
+  }
+
+  key = _pressed;
+  _pressed = -1;
+  if (key < 0)
+    return;
+
+  c = keyChar(key);
+  switch (c)
+  {
+  case GU_KEY_LAYOUT:
+    // All the keys change.
+    _symbols = !_symbols;
+    _shift = false;
+    layout();
+    drawKeys();
+    return;
+
+  case GU_KEY_SHIFT:
+    _shift = !_shift;
+    drawKeys();
+    return;
+
+  case GU_KEY_BACKSPACE:
+    drawKey(key, false);
+    deleteChar();
+    break;
+
+  case GU_KEY_ENTER:
+    drawKey(key, false);
+    break;
+
+  default:
+    // A shift only lasts for one letter; put the letters back after it.
+    if (_shift)
+    {
+      _shift = false;
+      drawKeys();
+    }
+    else
+    {
+      drawKey(key, false);
+    }
+    addChar(c);
+    break;
+  }
+
+  if (_callback != NULL)
+    (*_callback)(ev, (_indx << 8) | (uint8_t)c, _param, x, y);
+}
+
+// Wrapper outside the class so it can be passed as a function pointer.
+void keyboard_tap_wrapper(EventType ev, int indx, void *param, int x, int y)
+{
+  GU_Keyboard *kbd = (GU_Keyboard *)param;
+
+  GU_Trace::event(GU_TRACE_KEYBOARD, ev, indx, param, x, y);
+  GU_LATENCY_START(GU_LATENCY_KEY);
+  kbd->keyboard_tap_cb(ev, indx, param, x, y);
+  GU_LATENCY_STOP(GU_LATENCY_KEY);
+}
@@ -0,0 +1,101 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+
+// Latency probes.
+
+unsigned long GU_Latency::_start[GU_LATENCY_KINDS];
+uint32_t GU_Latency::_count[GU_LATENCY_KINDS];
+uint32_t GU_Latency::_max[GU_LATENCY_KINDS];
+uint32_t GU_Latency::_buckets[GU_LATENCY_KINDS][GU_LATENCY_BUCKETS];
+
+static const char *kind_names[GU_LATENCY_KINDS] =
+  { "menu tap", "menu drag", "swipe", "dots", "key", "slider", "queue" };
+
+// Bucket for a time. Past 16us, the top bit of the time gives the power of 2
+// and the next two bits the quarter within it.
+int GU_Latency::bucket(uint32_t us)
+{
+  int e, b;
+
+  if (us < 16)
+    return us;
+  e = 31 - __builtin_clz(us);
+  b = 16 + (e - 4) * 4 + ((us >> (e - 2)) & 3);
+  return min(b, GU_LATENCY_BUCKETS - 1);
+}
+
+// Longest time that goes in a bucket.
+uint32_t GU_Latency::bucketTop(int b)
+{
+  int e, quarter;
+
+  if (b < 16)
+    return b;
+  e = 4 + (b - 16) / 4;
+  quarter = (b - 16) % 4;
+  return ((uint32_t)(5 + quarter) << (e - 2)) - 1;
+}
+
+void GU_Latency::stop(GU_LatencyKind kind)
+{
+  record(kind, micros() - _start[kind]);
+}
+
+void GU_Latency::record(GU_LatencyKind kind, uint32_t us)
+{
+  _count[kind]++;
+  _buckets[kind][bucket(us)]++;
+  if (us > _max[kind])
+    _max[kind] = us;
+}
+
+uint32_t GU_Latency::percentile(GU_LatencyKind kind, int pct)
+{
+  uint32_t n = 0;
+  uint32_t want;
+
+  if (_count[kind] == 0)
+    return 0;
+
+  // The rank of the percentile, rounded up, and at least the first.
+  want = max((uint32_t)1, (uint32_t)(((uint64_t)_count[kind] * pct + 99) / 100));
+  for (int b = 0; b < GU_LATENCY_BUCKETS; b++)
+  {
+    n += _buckets[kind][b];
+    if (n >= want)
+      return min(bucketTop(b), _max[kind]);
+  }
+  return _max[kind];
+}
+
+void GU_Latency::reset(void)
+{
+  for (int k = 0; k < GU_LATENCY_KINDS; k++)
+  {
+    _count[k] = 0;
+    _max[k] = 0;
+    for (int b = 0; b < GU_LATENCY_BUCKETS; b++)
+      _buckets[k][b] = 0;
+  }
+}
+
+void GU_Latency::dump(Print *out)
+{
+  for (int k = 0; k < GU_LATENCY_KINDS; k++)
+  {
+    GU_LatencyKind kind = (GU_LatencyKind)k;
+
+    out->print(kind_names[k]);
+    out->print(": n ");
+    out->print(_count[k]);
+    out->print(" p50 ");
+    out->print(percentile(kind, 50));
+    out->print(" p95 ");
+    out->print(percentile(kind, 95));
+    out->print(" p99 ");
+    out->print(percentile(kind, 99));
+    out->print(" max ");
+    out->print(_max[k]);
+    out->println(" us");
+  }
+}
@@ -1,13 +1,34 @@
 #include "Arduino.h"
 #include "GU_Elements.h"
 
+// The items, their labels and the tip are held by the subclass. Each item
+// keeps its own label buffer; the rows are rotated, not copied, when they
+// move, so the buffers stay with them.
+GU_BasicMenu::GU_BasicMenu(FontCollection *fc, GestureDetector *gd,
+                           GU_MenuItem *items, int max_items, char *labels, int label_len,
+                           char *tip, int tip_len)
+{
+  _gd = gd;
+  _fc = fc;
+  _gfx = fc->_gfx;
+  _items = items;
+  _max_items = max_items;
+  _label_len = label_len;
+  _tip = tip;
+  _tip_len = tip_len;
+  for (int i = 0; i < max_items; i++)
+    _items[i].label = labels + i * label_len;
+  _scratch.label = labels + max_items * label_len;
+  GU_Trace::addElement(this);
+}
+
 // Set up a menu.
-void GU_Menu::initMenu(GU_Button *button,
+void GU_BasicMenu::initMenu(GU_BasicButton *button,
               uint16_t outline, uint16_t fill,
               uint16_t highlight, uint16_t textcolor,
               TapCB callback, int indx, void *param)
 {
-  int16_t x, y;
+  GU_TextBounds em;
 
   _button = button;
   _outlinecolor = outline;
@@ -24,13 +45,18 @@ void GU_Menu::initMenu(GU_Button *button,
   _n_displayed = 0;
   _first_displayed = 0;
   _tip[0] = '\0';
+  _source = NULL;
+  _cached_first = -1;
+  _batching = false;
   _callback = callback;
   _indx = indx;
   _param = param;
 
   // Item height is derived from button, but may have a little extra to stop
   // crowding based on the font.
-  _fc->getTextBounds("M", 0, 0, &x, &y, &_em_width, &_em_height, _textsize);
+  GU_TextMetrics::getTextBounds(_fc, "M", _textsize, &em);
+  _em_width = em.w;
+  _em_height = em.h;
   _itemheight = max(_button->_h, 2 * _em_height);
 
   // Take account of buttons near the bottom
@@ -41,12 +67,9 @@ void GU_Menu::initMenu(GU_Button *button,
 }
 
 // Set up a menu item at the given index (zero based) within the menu.
-void GU_Menu::setMenuItem(int indx, char *text, bool enabled, bool checked, bool underlined)
+void GU_BasicMenu::setMenuItem(int indx, char *text, bool enabled, bool checked, bool underlined)
 {
-  int16_t x, y;
-  uint16_t w, h;
-
-  if (indx < 0 || indx > MAX_ITEMS - 1)
+  if (indx < 0 || indx > _max_items - 1 || _source != NULL)
     return;   // out of range
 
   if (indx >= _n_items)
@@ -57,17 +80,41 @@ void GU_Menu::setMenuItem(int indx, char *text, bool enabled, bool checked, bool
   _items[indx].enabled = enabled;
   _items[indx].checked = checked;
   _items[indx].underlined = underlined;
-  strncpy(_items[indx].label, text, 19);
-  _items[indx].label[19] = 0;
+  strncpy(_items[indx].label, text, _label_len - 1);
+  _items[indx].label[_label_len - 1] = 0;
+
+  // Measure the item. Give it a little extra room on left and right, esp for check marks
+  GU_TextMetrics::getTextBounds(_fc, _items[indx].label, _textsize, &_items[indx].bounds);
+  _items[indx].itemwidth = _items[indx].bounds.w + 3 * _em_width;
+  if (_batching)
+    return;   // laid out at the commit
+
+  growMenu(_items[indx].itemwidth);
+
+#if 0
+  Serial.print("SetMenuItem: xywh ");
+  Serial.print(_x1);
+  Serial.print(" ");
+  Serial.print(_y1);
+  Serial.print(" ");
+  Serial.print(_w);
+  Serial.print(" ");
+  Serial.println(_h);
+#endif
+
+  // Set a tap on the associated button using internal callbacks. Use the menu's event index
+  // as there may be more than one of these going at the same time.
+  _button->onTap(menu_tap_wrapper, _indx, (void *)this);
+}
 
-  // Accumulate the item into the menu area bounds.
-  // Give it a little extra room on left and right, esp for check marks
-  _fc->getTextBounds(_items[indx].label, 0, 0, &x, &y, &_items[indx].itemwidth, &h, _textsize);
-  _items[indx].itemwidth += 3 * _em_width;
+// Accumulate an item into the menu area bounds.
+void GU_BasicMenu::growMenu(uint16_t w)
+{
+  uint16_t h;
 
-  if (_items[indx].itemwidth > _w)
+  if (w > _w)
   {
-    _w = _items[indx].itemwidth;
+    _w = w;
     if (_x1 + _w >= _gfx->width())
       _x1 = _gfx->width() - _w - 1;   // push it back onto the screen
   }
@@ -87,134 +134,439 @@ void GU_Menu::setMenuItem(int indx, char *text, bool enabled, bool checked, bool
         _y1 = 0;
     }
   }
+}
 
-#if 0
-  Serial.print("SetMenuItem: xywh ");
-  Serial.print(_x1);
-  Serial.print(" ");
-  Serial.print(_y1);
-  Serial.print(" ");
-  Serial.print(_w);
-  Serial.print(" ");
-  Serial.println(_h);
-#endif
+// Lay out the items set since beginMenuItems in one pass, from the widest.
+void GU_BasicMenu::commitMenuItems(void)
+{
+  uint16_t w = 0;
 
-  // Set a tap on the associated button using internal callbacks. Use the menu's event index
-  // as there may be more than one of these going at the same time.
-  _gd->onTap(_button->_x1, _button->_y1, _button->_w, _button->_h, menu_tap_wrapper, _indx, (void *)this);
+  _batching = false;
+  if (_n_items == 0 || _source != NULL)
+    return;
+  for (int i = 0; i < _n_items; i++)
+    w = max(w, _items[i].itemwidth);
+  growMenu(w);
+  _button->onTap(menu_tap_wrapper, _indx, (void *)this);
+}
+
+void GU_BasicMenu::setMenuItems(char **labels, int n_items)
+{
+  beginMenuItems();
+  for (int i = 0; i < n_items; i++)
+    setMenuItem(i, labels[i]);
+  commitMenuItems();
+}
+
+// Set up a menu whose items are supplied on demand by a callback.
+void GU_BasicMenu::setItemSource(int n_items, uint16_t width, MenuItemCB source, void *param)
+{
+  _source = source;
+  _source_param = param;
+  _cached_first = -1;
+  _n_items = n_items;
+
+  // Only the displayed rows are held, one per entry in _items.
+  _max_displayed = min(_max_displayed, _max_items);
+  _n_displayed = min(_n_items, _max_displayed);
+
+  _w = width;
+  if (_x1 + _w >= _gfx->width())
+    _x1 = _gfx->width() - _w - 1;   // push it back onto the screen
+
+  _h = _n_displayed * _itemheight;
+  if (_button->_y1 > _gfx->height() / 2)
+  {
+    _y1 = _button->_y1 - _h;
+    if (_y1 < 0)
+      _y1 = 0;
+  }
+
+  _button->onTap(menu_tap_wrapper, _indx, (void *)this);
+}
+
+// Fetch an item from the source, and measure it.
+void GU_BasicMenu::fetchItem(int i, GU_MenuItem *item)
+{
+  item->label[0] = '\0';
+  item->enabled = true;
+  item->checked = false;
+  item->underlined = false;
+  (*_source)(i, item->label, _label_len, &item->enabled, &item->checked, _source_param);
+  item->label[_label_len - 1] = '\0';
+
+  GU_TextMetrics::getTextBounds(_fc, item->label, _textsize, &item->bounds);
+  item->itemwidth = item->bounds.w + 3 * _em_width;
+}
+
+// Fetch the displayed rows for a menu with a source. When the menu has
+// scrolled by one row, the others are kept and only the new row is fetched.
+void GU_BasicMenu::fetchRows(void)
+{
+  int shift = _first_displayed - _cached_first;
+
+  if (_cached_first >= 0 && shift == 1 && _n_displayed > 1)
+  {
+    GU_MenuItem first = _items[0];
+
+    memmove(&_items[0], &_items[1], (_n_displayed - 1) * sizeof(GU_MenuItem));
+    _items[_n_displayed - 1] = first;
+    fetchItem(_first_displayed + _n_displayed - 1, &_items[_n_displayed - 1]);
+  }
+  else if (_cached_first >= 0 && shift == -1 && _n_displayed > 1)
+  {
+    GU_MenuItem last = _items[_n_displayed - 1];
+
+    memmove(&_items[1], &_items[0], (_n_displayed - 1) * sizeof(GU_MenuItem));
+    _items[0] = last;
+    fetchItem(_first_displayed, &_items[0]);
+  }
+  else
+  {
+    for (int r = 0; r < _n_displayed; r++)
+      fetchItem(_first_displayed + r, &_items[r]);
+  }
+  _cached_first = _first_displayed;
+}
+
+// Get a menu item. Items of a menu with a source are fetched as needed:
+// displayed items into the row they're displayed in, any others into _scratch.
+GU_BasicMenu::GU_MenuItem *GU_BasicMenu::getItem(int i)
+{
+  if (_source == NULL)
+    return &_items[i];
+
+  if (!isItemDisplayed(i))
+  {
+    fetchItem(i, &_scratch);
+    return &_scratch;
+  }
+  if (_cached_first != _first_displayed)
+    fetchRows();
+  return &_items[i - _first_displayed];
+}
+
+// Fetch an item again from the source, redrawing it if the menu is up.
+void GU_BasicMenu::refreshMenuItem(int indx)
+{
+  if (_source == NULL || !isItemDisplayed(indx) || _cached_first != _first_displayed)
+    return;   // it will be fetched when it's next needed
+
+  fetchItem(indx, &_items[indx - _first_displayed]);
+  if (_displayed)
+    drawMenuItem(indx, indx == _curr_item, true);
 }
 
 // Disable/enable a menu item.
-void GU_Menu::enableMenuItem(int indx, bool enabled)
+void GU_BasicMenu::enableMenuItem(int indx, bool enabled)
 {
-  if (indx < 0 || indx > MAX_ITEMS - 1)
+  if (indx < 0 || indx > _max_items - 1 || _source != NULL)
     return;   // out of range
 
   _items[indx].enabled = enabled;
+
+  // If the menu is up, redraw just this item.
+  if (_displayed && isItemDisplayed(indx))
+    drawMenuItem(indx, indx == _curr_item, true);
 }
 
 // Set the checkbox in a menu item.
-void GU_Menu::checkMenuItem(int indx, bool checked)
+void GU_BasicMenu::checkMenuItem(int indx, bool checked)
 {
-  if (indx < 0 || indx > MAX_ITEMS - 1)
+  if (indx < 0 || indx > _max_items - 1 || _source != NULL)
     return;   // out of range
 
   _items[indx].checked = checked;
+
+  // If the menu is up, redraw just this item.
+  if (_displayed && isItemDisplayed(indx))
+    drawMenuItem(indx, indx == _curr_item, true);
 }
 
 // Store the menu tip.
-void GU_Menu::setTip(char *tip)
+void GU_BasicMenu::setTip(char *tip)
 {
-  strncpy(_tip, tip, 79);
-  _tip[79] = 0; // strncpy does not place a null at the end.
+  strncpy(_tip, tip, _tip_len - 1);
+  _tip[_tip_len - 1] = 0; // strncpy does not place a null at the end.
+  GU_TextMetrics::getTextBounds(_fc, _tip, _textsize, &_tip_bounds);
 }
 
-// Draw the menu with (optionally) one item highlighted.
-void GU_Menu::drawMenu(int highlight_item)
+// Draw one menu item in its displayed row, highlighted or not.
+// If outline is set, also redraw the parts of the menu outline that
+// the row overwrote, so the row can be drawn on its own.
+void GU_BasicMenu::drawMenuItem(int i, bool highlight, bool outline)
 {
-  int16_t x, y;
-  uint16_t w, h, color;
+  uint16_t color;
   int16_t item_y1, item_text_y;
+  GU_MenuItem *item = getItem(i);
+  GU_FrameBuffer fb(_gfx);
 
-  item_y1 = _y1;
-  for (int i = _first_displayed; i < _first_displayed + _n_displayed; i++)
-  {
-    if (i == highlight_item && _items[i].enabled)
-      _gfx->fillRect(_x1, item_y1, _w, _itemheight, _highlightcolor);
-    else
-      _gfx->fillRect(_x1, item_y1, _w, _itemheight, _fillcolor);
+  GU_Stats::setWidget(this, GU_STATS_MENU);
+  item_y1 = _y1 + (i - _first_displayed) * _itemheight;
+  if (highlight && item->enabled)
+    fb.fillRect(_x1, item_y1, _w, _itemheight, _highlightcolor);
+  else
+    fb.fillRect(_x1, item_y1, _w, _itemheight, _fillcolor);
 
-    if (_items[i].underlined)
-      _gfx->drawLine(_x1, item_y1 + _itemheight - 1,
-                    _x1 + _w - 1, item_y1 + _itemheight - 1,
-                    _outlinecolor);
+  if (item->underlined)
+    fb.drawFastHLine(_x1, item_y1 + _itemheight - 1, _w, _outlinecolor);
 
-    if (_items[i].enabled)
-      color = _textcolor;
-    else
-      color = _disabledtext;
-    _fc->getTextBounds(_items[i].label, _x1, item_y1, &x, &y, &w, &h, _textsize);
+  if (item->enabled)
+    color = _textcolor;
+  else
+    color = _disabledtext;
 
-    // X placement allows for checkmarks, Y placement is as for button with font adjustment.
-    item_text_y = item_y1 + (_itemheight / 2) - (h / 2) + (item_y1 - y);
+  // X placement allows for checkmarks, Y placement is as for button with font adjustment.
+  item_text_y = item_y1 + (_itemheight / 2) - (item->bounds.h / 2) - item->bounds.y;
 
-    // If there are more items before the beginning or after the end,
-    // put in a little arrow indicator (instead of any check mark)
-    if (i == _first_displayed && _first_displayed > 0)
-    {
-      // Draw a solid up arrow. Use text color even if disabled.
-      _fc->drawText((char)13, _x1 + (_em_width / 2), item_text_y, _textcolor, _textsize);
-    }
-    else if (i == _first_displayed + _n_displayed - 1 && i < _n_items - 1)
-    {
-      // Draw a solid down arrow
-      _fc->drawText((char)14, _x1 + (_em_width / 2), item_text_y, _textcolor, _textsize);
-    }
-    else if (_items[i].checked)
-    {
-      // Draw a tick mark
-      _fc->drawText((char)25, _x1 + (_em_width / 2), item_text_y, color, _textsize);
-    }
+  // If there are more items before the beginning or after the end,
+  // put in a little arrow indicator (instead of any check mark)
+  if (i == _first_displayed && _first_displayed > 0)
+  {
+    // Draw a solid up arrow. Use text color even if disabled.
+    fb.drawText(_fc, (char)13, _x1 + (_em_width / 2), item_text_y, _textcolor, _textsize);
+  }
+  else if (i == _first_displayed + _n_displayed - 1 && i < _n_items - 1)
+  {
+    // Draw a solid down arrow
+    fb.drawText(_fc, (char)14, _x1 + (_em_width / 2), item_text_y, _textcolor, _textsize);
+  }
+  else if (item->checked)
+  {
+    // Draw a tick mark
+    fb.drawText(_fc, (char)25, _x1 + (_em_width / 2), item_text_y, color, _textsize);
+  }
 
-    _fc->drawText(_items[i].label, _x1 + 2 * _em_width, item_text_y, color, _textsize);
+  fb.drawText(_fc, item->label, _x1 + 2 * _em_width, item_text_y, color, _textsize);
 
 #if 0
-    Serial.print(_x1);
-    Serial.print(" ");
-    Serial.print(item_y1);
-    Serial.print(" adjust ");
-    Serial.print(item_y1 - y);
-    Serial.print(" Bounds h ");
-    Serial.print(h);
-    Serial.print(" ");
-    Serial.println(_items[i].label);
+  Serial.print(_x1);
+  Serial.print(" ");
+  Serial.print(item_y1);
+  Serial.print(" adjust ");
+  Serial.print(-item->bounds.y);
+  Serial.print(" Bounds h ");
+  Serial.print(item->bounds.h);
+  Serial.print(" ");
+  Serial.println(item->label);
 #endif
 
-    item_y1 += _itemheight;
+  if (outline)
+  {
+    fb.drawFastVLine(_x1, item_y1, _itemheight, _outlinecolor);
+    fb.drawFastVLine(_x1 + _w - 1, item_y1, _itemheight, _outlinecolor);
+    if (i == _first_displayed)
+      fb.drawFastHLine(_x1, _y1, _w, _outlinecolor);
+    if (i == _first_displayed + _n_displayed - 1)
+      fb.drawFastHLine(_x1, _y1 + _h - 1, _w, _outlinecolor);
   }
+}
+
+// Is the item in one of the displayed rows?
+bool GU_BasicMenu::isItemDisplayed(int i)
+{
+  return i >= _first_displayed && i < _first_displayed + _n_displayed;
+}
+
+// Draw the menu with (optionally) one item highlighted.
+void GU_BasicMenu::drawMenu(int highlight_item)
+{
+  GU_FrameBuffer fb(_gfx);
+
+  GU_Stats::setWidget(this, GU_STATS_MENU);
+  for (int i = _first_displayed; i < _first_displayed + _n_displayed; i++)
+    drawMenuItem(i, i == highlight_item, false);
 
   // Outline the menu area and draw the optional tip in the highlight color.
-  _gfx->drawRect(_x1, _y1, _w, _h, _outlinecolor);
+  fb.drawRect(_x1, _y1, _w, _h, _outlinecolor);
   if (_tip[0] != '\0')
   {
-    _gfx->fillRect(0, _button->_y1, _gfx->width(), _button->_h, _highlightcolor);
-    _fc->getTextBounds(_tip, 0, _button->_y1, &x, &y, &w, &h, _textsize);
-    _fc->drawText(_tip, _gfx->width() / 2 - w / 2, _button->_y1 + h, _textcolor, _textsize);
+    fb.fillRect(0, _button->_y1, _gfx->width(), _button->_h, _highlightcolor);
+    fb.drawText(_fc, _tip, _gfx->width() / 2 - _tip_bounds.w / 2, _button->_y1 + _tip_bounds.h,
+                _textcolor, _textsize);
   }
+
+  // Remember what is on the screen, so highlight changes can be drawn
+  // by redrawing single rows.
+  _drawn_first = _first_displayed;
 }
 
-// Redraw the menu if the highlight has changed.
-void GU_Menu::drawIfChanged(int item)
+// Redraw the menu if the highlight has changed. If the menu has not scrolled
+// since it was last drawn, only the rows losing and gaining the highlight
+// are redrawn. Disabled items don't show the highlight, so they are left alone.
+// If it has scrolled by one row, the rows are moved on the screen instead.
+void GU_BasicMenu::drawIfChanged(int item)
 {
-  if (item != _curr_item)
+  int scrolled = _first_displayed - _drawn_first;
+
+  if (scrolled == 1 || scrolled == -1)
+  {
+    drawScrolled(scrolled, item);
+  }
+  else if (scrolled != 0)
+  {
+    drawMenu(item);
+    _curr_item = item;
+  }
+  else if (item != _curr_item)
+  {
+    if (isItemDisplayed(_curr_item) && getItem(_curr_item)->enabled)
+      drawMenuItem(_curr_item, false, true);
+    if (isItemDisplayed(item) && getItem(item)->enabled)
+      drawMenuItem(item, true, true);
+    _curr_item = item;
+  }
+}
+
+// The menu has scrolled by one row since it was drawn. Move the rows that are
+// still displayed up or down by a row, then draw the row that has come into
+// view, and the rows whose scroll arrows or highlight have changed.
+void GU_BasicMenu::drawScrolled(int scrolled, int item)
+{
+  GU_FrameBuffer fb(_gfx);
+  int first = _first_displayed;
+  int last = _first_displayed + _n_displayed - 1;
+  int redraw[5];
+  int n_redraw = 0;
+
+  GU_Stats::setWidget(this, GU_STATS_MENU);
+  if (!fb.isValid() || _n_displayed < 2)
   {
     drawMenu(item);
     _curr_item = item;
+    return;
+  }
+
+  if (scrolled > 0)
+  {
+    fb.moveRect(_x1, _y1 + _itemheight, _w, _h - _itemheight, 0, -_itemheight);
+    redraw[n_redraw++] = last;        // new row
+    redraw[n_redraw++] = last - 1;    // loses its down arrow
+    redraw[n_redraw++] = first;       // may gain an up arrow, and the top outline
+  }
+  else
+  {
+    fb.moveRect(_x1, _y1, _w, _h - _itemheight, 0, _itemheight);
+    redraw[n_redraw++] = first;       // new row
+    redraw[n_redraw++] = first + 1;   // loses its up arrow
+    redraw[n_redraw++] = last;        // may gain a down arrow, and the bottom outline
+  }
+  _drawn_first = _first_displayed;
+
+  // The highlight moved with its row. Move it if the item has changed.
+  if (item != _curr_item)
+  {
+    redraw[n_redraw++] = _curr_item;
+    redraw[n_redraw++] = item;
+    _curr_item = item;
+  }
+
+  for (int r = 0; r < n_redraw; r++)
+  {
+    bool done = !isItemDisplayed(redraw[r]);
+
+    for (int k = 0; k < r && !done; k++)
+      done = redraw[k] == redraw[r];
+    if (!done)
+      drawMenuItem(redraw[r], redraw[r] == item, true);
+  }
+}
+
+// Scroll the menu a row at a time until the given item is first displayed.
+void GU_BasicMenu::scrollTo(int first)
+{
+  first = max(0, min(first, _n_items - _n_displayed));
+  while (_first_displayed != first)
+  {
+    _first_displayed += (first > _first_displayed) ? 1 : -1;
+    drawIfChanged(-1);
+  }
+}
+
+// Scroll the menu by dragging in the scroll arrow column. The menu follows the
+// finger, and nothing is highlighted. When released while still moving, the
+// menu keeps scrolling, slowing down until it stops (or reaches the end).
+// The menu stays up afterwards; nothing is selected.
+void GU_BasicMenu::scrollDrag(EventType ev, int dy)
+{
+  unsigned long now = GU_Trace::now();
+  unsigned long elapsed;
+
+  if (!_scrolling)
+  {
+    _scrolling = true;
+    _scroll_first = _first_displayed;
+    _scroll_dy = 0;
+    _scroll_millis = now;
+    _scroll_speed = 0;
+  }
+
+  // Track the speed in rows per second, smoothed over the last few moves.
+  // A pause forgets the earlier moves.
+  elapsed = now - _scroll_millis;
+  if (dy != _scroll_dy && elapsed > 0)
+  {
+    float speed = -(float)(dy - _scroll_dy) * 1000 / ((float)_itemheight * elapsed);
+
+    if (elapsed > 100)
+      _scroll_speed = speed;
+    else
+      _scroll_speed = (_scroll_speed + speed) / 2;
+    _scroll_dy = dy;
+    _scroll_millis = now;
+  }
+
+  scrollTo(_scroll_first - dy / _itemheight);
+
+  if (ev & EV_RELEASED)
+  {
+    _scrolling = false;
+    if (elapsed < 100)
+      fling(_scroll_speed);
   }
 }
 
+// Keep scrolling with momentum after a flick. The menu is moved on a step
+// each frame by GU_Frame::tick, slowing down until it stops, reaches the end,
+// or the menu is touched again.
+void GU_BasicMenu::fling(float speed)
+{
+  _fling_pos = _first_displayed;
+  _fling_speed = speed;
+  _fling_millis = GU_Trace::now();
+  GU_Frame::animate(this, menu_fling_wrapper);
+}
+
+// Move on by the time since the last step. Friction takes off 8% of the
+// speed every 16ms.
+bool GU_BasicMenu::flingStep(void)
+{
+  unsigned long now = GU_Trace::now();
+  float elapsed = now - _fling_millis;
+  float last = _n_items - _n_displayed;
+
+  _fling_millis = now;
+  _fling_pos += _fling_speed * elapsed / 1000;
+  _fling_speed *= powf(0.92f, elapsed / 16);
+  _fling_pos = max(0.0f, min(_fling_pos, last));
+  scrollTo((int)(_fling_pos + 0.5f));
+
+  if (!_displayed)
+    return false;
+  if (_fling_speed > 2)
+    return _fling_pos < last;
+  if (_fling_speed < -2)
+    return _fling_pos > 0;
+  return false;
+}
+
+bool menu_fling_wrapper(void *element)
+{
+  return ((GU_BasicMenu *)element)->flingStep();
+}
+
 // Determine which item the x/y are in, or -1 if it's outside the menu.
-int GU_Menu::determineItem(int x, int y)
+int GU_BasicMenu::determineItem(int x, int y)
 {
   int i;
 
@@ -228,12 +580,12 @@ int GU_Menu::determineItem(int x, int y)
 
   // See how long we are hanging around in any one item.
   if (i != _curr_item)
-    _start_millis = millis();
+    _start_millis = GU_Trace::now();
 
   // If we spend time in the first (or last) item, and there is more to
   // display in that direction, alter _first_displayed to suit (this will
   // cause the menu to be scrolled).
-  if (millis() - _start_millis > 500)
+  if (GU_Trace::now() - _start_millis > 500)
   {
     if (i == _first_displayed && _first_displayed > 0)
     {
@@ -251,38 +603,136 @@ int GU_Menu::determineItem(int x, int y)
 }
 
 // Call user's callback function and clean up internal tap and drag events.
-void GU_Menu::userCallbackAndCleanUp(int item, int x, int y)
+void GU_BasicMenu::userCallbackAndCleanUp(int item, int x, int y)
 {
   // If not enabled, return -1. Defer this check till now so curr_item
   // remaind valid to help with scrolling.
-  if (!_items[item].enabled)
+  if (item < 0 || !getItem(item)->enabled)
     item = -1;
+  _selected = item;
+  stopFling();
+
+  // Put back what was under the menu before telling the user.
+  if (_displayed && _save_under)
+    restoreUnder();
+  _displayed = false;
 
   // Call user's calback with user's supplied index and param.
-  // The user's index in the high byte, the menu item index in the low byte.
+  // The user's index in the high byte, the menu item index in the low byte
+  // (0xFF if none, and saturating at 0xFE for very long menus).
   // the x/y are not important but need to be passed anyway.
-  (*_callback)(EV_TAP, (_indx << 8) | item, _param, x, y);
+  (*_callback)(EV_TAP, (_indx << 8) | (item < 0 ? 0xFF : min(item, 0xFE)), _param, x, y);
 
   // Clean up the other menu callbacks.
-  _gd->cancelEvent(MAX_EVENTS - 4);
-  _gd->cancelEvent(MAX_EVENTS - 3);
-  _gd->cancelEvent(MAX_EVENTS - 2);
-  _gd->cancelEvent(MAX_EVENTS - 1);
+  _gd->cancelEvent(GU_SLOT_MENU_CANCEL);
+  _gd->cancelEvent(GU_SLOT_MENU_ITEM_DRAG);
+  _gd->cancelEvent(GU_SLOT_MENU_ITEM_TAP);
+  _gd->cancelEvent(GU_SLOT_MENU_BUTTON_DRAG);
+}
+
+// A menu going away takes its tap on the button with it, and its other
+// events if it is displayed. (In an arena, make the menu after its button,
+// so that it goes first.)
+GU_BasicMenu::~GU_BasicMenu()
+{
+  if (_button != NULL)
+    _button->cancelTap(_indx);
+  if (_displayed)
+  {
+    _gd->cancelEvent(GU_SLOT_MENU_CANCEL);
+    _gd->cancelEvent(GU_SLOT_MENU_ITEM_DRAG);
+    _gd->cancelEvent(GU_SLOT_MENU_ITEM_TAP);
+    _gd->cancelEvent(GU_SLOT_MENU_BUTTON_DRAG);
+  }
+  GU_FrameBuffer::freePixels(_saved);
+  stopFling();
+  GU_Trace::removeElement(this);
 }
 
-void GU_Menu::destroyMenu(void)
+void GU_BasicMenu::destroyMenu(void)
 {
-  _gd->cancelEvent(_indx);
+  _button->cancelTap(_indx);
+  _displayed = false;
+  stopFling();
+
+  GU_FrameBuffer::freePixels(_saved);
+  _saved = NULL;
+  _saved_size = 0;
 
   // Clean up the other menu callbacks.
-  _gd->cancelEvent(MAX_EVENTS - 4);
-  _gd->cancelEvent(MAX_EVENTS - 3);
-  _gd->cancelEvent(MAX_EVENTS - 2);
-  _gd->cancelEvent(MAX_EVENTS - 1);
+  _gd->cancelEvent(GU_SLOT_MENU_CANCEL);
+  _gd->cancelEvent(GU_SLOT_MENU_ITEM_DRAG);
+  _gd->cancelEvent(GU_SLOT_MENU_ITEM_TAP);
+  _gd->cancelEvent(GU_SLOT_MENU_BUTTON_DRAG);
+}
+
+// Save the pixels under the menu area, and the tip bar if there is a tip.
+// If the screen behind is to be darkened, save all of it.
+// The buffer is kept for next time, and only grows if the menu does.
+void GU_BasicMenu::saveUnder(void)
+{
+  GU_FrameBuffer fb(_gfx);
+  uint32_t size = (uint32_t)_w * _h;
+
+  if (_dim_behind > 0)
+    size = (uint32_t)_gfx->width() * _gfx->height();
+  else if (_tip[0] != '\0')
+    size += (uint32_t)_gfx->width() * _button->_h;
+
+  if (size > _saved_size)
+  {
+    GU_FrameBuffer::freePixels(_saved);
+    _saved = GU_FrameBuffer::allocPixels(size);
+    _saved_size = _saved != NULL ? size : 0;
+  }
+  if (_saved == NULL)
+    return;
+
+  if (_dim_behind > 0)
+  {
+    fb.readRect(0, 0, _gfx->width(), _gfx->height(), _saved);
+    return;
+  }
+  fb.readRect(_x1, _y1, _w, _h, _saved);
+  if (_tip[0] != '\0')
+    fb.readRect(0, _button->_y1, _gfx->width(), _button->_h, _saved + _w * _h);
+}
+
+// Put back the pixels saved when the menu was displayed.
+void GU_BasicMenu::restoreUnder(void)
+{
+  GU_FrameBuffer fb(_gfx);
+
+  GU_Stats::setWidget(this, GU_STATS_MENU);
+  if (_saved == NULL)
+    return;
+
+  if (_dim_behind > 0)
+  {
+    fb.writeRect(0, 0, _gfx->width(), _gfx->height(), _saved);
+    return;
+  }
+  fb.writeRect(_x1, _y1, _w, _h, _saved);
+  if (_tip[0] != '\0')
+    fb.writeRect(0, _button->_y1, _gfx->width(), _button->_h, _saved + _w * _h);
+}
+
+// Darken the screen around the menu area (the menu is drawn over its own area).
+void GU_BasicMenu::dimBehind(void)
+{
+  GU_FrameBuffer fb(_gfx);
+  int16_t w = _gfx->width();
+  int16_t h = _gfx->height();
+
+  GU_Stats::setWidget(this, GU_STATS_MENU);
+  fb.blendRect(0, 0, w, _y1, BLACK, _dim_behind);
+  fb.blendRect(0, _y1, _x1, _h, BLACK, _dim_behind);
+  fb.blendRect(_x1 + _w, _y1, w - _x1 - _w, _h, BLACK, _dim_behind);
+  fb.blendRect(0, _y1 + _h, w, h - _y1 - _h, BLACK, _dim_behind);
 }
 
 // Callback rountines for menu selection.
-void GU_Menu::menu_tap_cb(EventType ev, int indx, void *param, int xtap, int ytap)
+void GU_BasicMenu::menu_tap_cb(EventType ev, int indx, void *param, int xtap, int ytap)
 {
   // Display the menu on tap down. No highlighted items (yet)
   if (ev & EV_RELEASED)
@@ -290,19 +740,25 @@ void GU_Menu::menu_tap_cb(EventType ev, int indx, void *param, int xtap, int yta
 
   _curr_item = -1;    // nothing is selected yet
   _first_displayed = 0;
+  _scrolling = false;
+  if (_save_under && !_displayed)
+    saveUnder();
+  if (_dim_behind > 0 && !_displayed)
+    dimBehind();
   drawMenu(-1);
+  _displayed = true;
 
   // Set a drag on the button to allow highlighting when dragged down into the menu.
-  // These use fixed index numbers (only one menu is ever active) and are at
-  // the highest priority.
-  _gd->onDrag(_button->_x1, _button->_y1, _button->_w, _button->_h, menu_drag_wrapper, MAX_EVENTS - 1, (void *)this);
+  // These use the menus' fixed events (only one menu is ever active), which
+  // are at the highest priority.
+  _gd->onDrag(_button->_x1, _button->_y1, _button->_w, _button->_h, menu_drag_wrapper, GU_SLOT_MENU_BUTTON_DRAG, (void *)this);
 
   // Set a tap and a drag on the menu area.
-  _gd->onTap(_x1, _y1, _w, _h, menu_item_wrapper, MAX_EVENTS - 2, (void *)this);
-  _gd->onDrag(_x1, _y1, _w, _h, menu_drag_wrapper, MAX_EVENTS - 3, (void *)this);
+  _gd->onTap(_x1, _y1, _w, _h, menu_item_wrapper, GU_SLOT_MENU_ITEM_TAP, (void *)this);
+  _gd->onDrag(_x1, _y1, _w, _h, menu_drag_wrapper, GU_SLOT_MENU_ITEM_DRAG, (void *)this);
 
   // Finally, a catch-all tap at lower priority to cancel the menu.
-  _gd->onTap(0, 0, 0, 0, menu_cancel_wrapper, MAX_EVENTS - 4, (void *)this);
+  _gd->onTap(0, 0, 0, 0, menu_cancel_wrapper, GU_SLOT_MENU_CANCEL, (void *)this);
 }
 
 // Wrappers outside the class so they can be passed as function pointers.
@@ -311,22 +767,30 @@ void GU_Menu::menu_tap_cb(EventType ev, int indx, void *param, int xtap, int yta
 // other events on the menu area.
 void menu_tap_wrapper(EventType ev, int indx, void *param, int x, int y)
 {
-  GU_Menu *menu = (GU_Menu *)param;
+  GU_BasicMenu *menu = (GU_BasicMenu *)param;
 
   // Not very nice in C++ I know, but at least it works to get back
   // into a member function.
+  GU_Trace::event(GU_TRACE_MENU_TAP, ev, indx, param, x, y);
+  GU_LATENCY_START(GU_LATENCY_MENU_TAP);
+  menu->stopFling();
   menu->menu_tap_cb(ev, indx, param, x, y);
+  GU_LATENCY_STOP(GU_LATENCY_MENU_TAP);
 }
 
 void menu_item_wrapper(EventType ev, int indx, void *param, int x, int y)
 {
-  GU_Menu *menu = (GU_Menu *)param;
+  GU_BasicMenu *menu = (GU_BasicMenu *)param;
 
+  GU_Trace::event(GU_TRACE_MENU_ITEM, ev, indx, param, x, y);
+  GU_LATENCY_START(GU_LATENCY_MENU_TAP);
+  menu->stopFling();
   menu->menu_item_cb(ev, indx, param, x, y);
+  GU_LATENCY_STOP(GU_LATENCY_MENU_TAP);
 }
 
 // Handle a tap on (or a drag into) a menu item. Return the selection when released.
-void GU_Menu::menu_item_cb(EventType ev, int indx, void *param, int x, int y)
+void GU_BasicMenu::menu_item_cb(EventType ev, int indx, void *param, int x, int y)
 {
   int item;
   bool scrolled = false;
@@ -368,39 +832,34 @@ void GU_Menu::menu_item_cb(EventType ev, int indx, void *param, int x, int y)
 // to highlight the items and return the selection when released.
 void menu_drag_wrapper(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
 {
-  menu_item_wrapper(ev, indx, param, x + dx, y + dy);
-}
+  GU_BasicMenu *menu = (GU_BasicMenu *)param;
 
-// Handle a tap outside the menu area to cancel the menu and return
-// a selection result of -1.
-void menu_cancel_wrapper(EventType ev, int indx, void *param, int x, int y)
-{
-  GU_Menu *menu = (GU_Menu *)param;
-
-  menu->userCallbackAndCleanUp(-1, x, y);
+  GU_Trace::event(GU_TRACE_MENU_DRAG, ev, indx, param, x, y, dx, dy);
+  GU_LATENCY_START(GU_LATENCY_MENU_DRAG);
+  menu->stopFling();
+  menu->menu_drag_cb(ev, indx, param, x, y, dx, dy);
+  GU_LATENCY_STOP(GU_LATENCY_MENU_DRAG);
 }
 
-// Pack and unpack a RGB565 color.
-void rgb565_unpack(uint16_t color, uint8_t *red, uint8_t *green, uint8_t *blue)
+// Drags that start in the scroll arrow column of a menu that doesn't all fit
+// on the screen scroll it. Other drags highlight the items they pass over.
+void GU_BasicMenu::menu_drag_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
 {
-  *red = (color >> 8) & 0xF8;
-  *green = (color >> 3) & 0xFC;
-  *blue = (color << 3) & 0xF8;
-}
-
-uint16_t rgb565_pack(uint8_t red, uint8_t green, uint8_t blue)
-{
-  return ((red & 0xF8) << 8) | ((green & 0xFC) << 3) | (blue >> 3);
+  if (_scrolling
+      || (indx == GU_SLOT_MENU_ITEM_DRAG && _n_items > _n_displayed && x - _x1 < 2 * _em_width))
+    scrollDrag(ev, dy);
+  else
+    menu_item_cb(ev, indx, param, x + dx, y + dy);
 }
 
-// Take the average of two RGB565 colors.
-uint16_t rgb565_average(uint16_t color1, uint16_t color2)
+// Handle a tap outside the menu area to cancel the menu and return
+// a selection result of -1.
+void menu_cancel_wrapper(EventType ev, int indx, void *param, int x, int y)
 {
-  uint8_t r1, g1, b1, r2, g2, b2;
+  GU_BasicMenu *menu = (GU_BasicMenu *)param;
 
-  rgb565_unpack(color1, &r1, &g1, &b1);
-  rgb565_unpack(color2, &r2, &g2, &b2);
-  return rgb565_pack((r1 + r2) / 2, (g1 + g2) / 2, (b1 + b2) / 2);
+  GU_Trace::event(GU_TRACE_MENU_CANCEL, ev, indx, param, x, y);
+  GU_LATENCY_START(GU_LATENCY_MENU_TAP);
+  menu->userCallbackAndCleanUp(-1, x, y);
+  GU_LATENCY_STOP(GU_LATENCY_MENU_TAP);
 }
-
-
@@ -0,0 +1,63 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+
+// Text metrics cache.
+
+GU_TextMetrics::GU_MetricsEntry GU_TextMetrics::_entries[GU_METRICS_ENTRIES];
+uint16_t GU_TextMetrics::_generation = 0;
+
+// Hash the string, font collection and text size (FNV-1a) to pick an entry.
+static uint32_t metrics_hash(FontCollection *fc, char *str, uint8_t textsize)
+{
+  uint32_t hash = 2166136261u ^ (uint32_t)(uintptr_t)fc ^ textsize;
+
+  while (*str != '\0')
+  {
+    hash ^= (uint8_t)*str++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Get the bounds of a string at (0, 0). Cache misses replace whatever was
+// in the entry before.
+void GU_TextMetrics::getTextBounds(FontCollection *fc, char *str, uint8_t textsize, GU_TextBounds *bounds)
+{
+  GU_MetricsEntry *e;
+
+  // With no font collection (invisible buttons) there is nothing to measure.
+  if (fc == NULL)
+  {
+    bounds->x = bounds->y = 0;
+    bounds->w = bounds->h = 0;
+    return;
+  }
+
+  e = &_entries[metrics_hash(fc, str, textsize) % GU_METRICS_ENTRIES];
+  if (e->fc == fc && e->textsize == textsize && strcmp(e->str, str) == 0)
+  {
+    *bounds = e->bounds;
+    return;
+  }
+
+  fc->getTextBounds(str, 0, 0, &bounds->x, &bounds->y, &bounds->w, &bounds->h, textsize);
+
+  if (strlen(str) <= GU_METRICS_MAXLEN)
+  {
+    e->fc = fc;
+    e->textsize = textsize;
+    strcpy(e->str, str);
+    e->bounds = *bounds;
+  }
+}
+
+// Empty the entries for a font collection, or all entries.
+void GU_TextMetrics::flush(FontCollection *fc)
+{
+  for (int i = 0; i < GU_METRICS_ENTRIES; i++)
+  {
+    if (fc == NULL || _entries[i].fc == fc)
+      _entries[i].fc = NULL;
+  }
+  _generation++;
+}
@@ -16,12 +16,18 @@ void GU_BasicPager::initPager(int n_pages, int first_page, DragCB callback, void
   _param = param;
   _fillcolor = fillcolor;
 
+  // Take the swipe's event before showing the page, so that pagers set up
+  // in the callback come above this one.
+  if (_swipe_slot < 0)
+    _swipe_slot = GU_Slots::alloc();
+
   // Show the first page. Set the page being left to 0xFF as we haven't been on a page.
   clearPage(true);
   (*_callback)(EV_SWIPE, (0xFF << 8) | first_page, param, 0, 0, 0, 0);
 
   // Trap left and right swipes.
-  _gd->onSwipe(0, 0, 0, 0, pager_swipe_wrapper, MAX_EVENTS - 5, (void *)this, CO_HORIZ, 3);
+  if (_swipe_slot >= 0)
+    _gd->onSwipe(0, 0, 0, 0, pager_swipe_wrapper, _swipe_slot, (void *)this, CO_HORIZ, 3);
 }
 
 void GU_BasicPager::destroyPager(void)
@@ -30,49 +36,122 @@ void GU_BasicPager::destroyPager(void)
   // This will also cancel the dots button
   clearPage(false);
   (*_callback)(EV_SWIPE, (_curr_page << 8) | 0xFF, _param, 0, 0, 0, 0);
+  if (_arena != NULL)
+    _arena->reset();
+  freeSlots();
+}
 
-  // cancel the swipe event
-  _gd->cancelEvent(MAX_EVENTS - 5);
+// Cancel the swipe event and give it back.
+void GU_BasicPager::freeSlots(void)
+{
+  if (_swipe_slot >= 0)
+    _gd->cancelEvent(_swipe_slot);
+  GU_Slots::free(_swipe_slot);
+  _swipe_slot = -1;
 }
 
 void GU_BasicPager::pager_swipe_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
 {
-  int leaving_page = _curr_page;
-
   // Detect whether swiping left (to higher numbered pages) or right (lower)
   if (dx > 0)
   {
     if (_curr_page > 0)
-    {
-      _curr_page--;
-      clearPage(true);
-      (*_callback)(EV_SWIPE, (leaving_page << 8) | _curr_page, param, x, y, dx, dy);
-    }
+      showPage(_curr_page - 1, x, y, dx, dy);
   }
   else
   {
     if (_curr_page < _num_pages - 1)
-    {
-      _curr_page++;
-      clearPage(true);
-      (*_callback)(EV_SWIPE, (leaving_page << 8) | _curr_page, param, x, y, dx, dy);
-    }
+      showPage(_curr_page + 1, x, y, dx, dy);
   }
 }
 
 void GU_BasicPager::gotoPage(int page)
+{
+  showPage(page, 0, 0, 0, 0);
+}
+
+// Leave the current page and show another, then tell the user so they can
+// take down the old page and set up the new one.
+void GU_BasicPager::showPage(int page, int x, int y, int dx, int dy)
 {
   int leaving_page = _curr_page;
+
+  leavePage(leaving_page);
+  if (_arena != NULL)
+    _arena->reset();
   _curr_page = page;
-  clearPage(true);
-  (*_callback)(EV_SWIPE, (leaving_page << 8) | _curr_page, _param, 0, 0, 0, 0);
+  if (_slide_frames > 0)
+    slidePage(leaving_page, page);
+  enterPage(page);
+  (*_callback)(EV_SWIPE, (leaving_page << 8) | _curr_page, _param, x, y, dx, dy);
+}
+
+// Slide a band of the screen across, a frame at a time. Each frame the content
+// already there is moved along, and the strip uncovered at the trailing edge
+// is drawn from the incoming page. Frames are paced to _slide_ms; if one
+// takes longer, give up and let the page be drawn in one go.
+bool GU_BasicPager::slideRegion(int16_t x, uint16_t w, bool leftwards, int page)
+{
+  GU_FrameBuffer fb(_gfx);
+  uint16_t h = _gfx->height();
+  int16_t shifted = 0;
+
+  GU_Stats::setWidget(this, statsKind());
+  if (!fb.isValid())
+    return false;
+
+  for (int k = 1; k <= _slide_frames; k++)
+  {
+    unsigned long start = GU_Trace::now();
+    int16_t step = (int32_t)w * k / _slide_frames - shifted;
+
+    if (leftwards)
+    {
+      // Incoming page comes in from the right.
+      fb.moveRect(x + step, 0, w - step, h, -step, 0);
+      drawSlideStrip(page, x + w - step, step, shifted);
+    }
+    else
+    {
+      // Incoming page comes in from the left.
+      fb.moveRect(x, 0, w - step, h, step, 0);
+      drawSlideStrip(page, x, step, w - shifted - step);
+    }
+    shifted += step;
+
+    if (GU_Trace::now() - start > _slide_ms)
+      return false;
+    while (GU_Trace::now() - start < _slide_ms)
+      GU_Trace::wait(1);
+  }
+  return true;
+}
+
+// The basic pager just clears the screen, and fills the strips as they slide in.
+void GU_BasicPager::clearPage(bool indicator)
+{
+  GU_FrameBuffer fb(_gfx);
+
+  GU_Stats::setWidget(this, statsKind());
+  fb.fillRect(0, 0, _gfx->width(), _gfx->height(), _fillcolor);
+}
+
+void GU_BasicPager::drawSlideStrip(int page, int16_t x, uint16_t w, int16_t src_x)
+{
+  GU_FrameBuffer fb(_gfx);
+
+  GU_Stats::setWidget(this, statsKind());
+  fb.fillRect(x, 0, w, _gfx->height(), _fillcolor);
 }
 
 void pager_swipe_wrapper(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
 {
   GU_BasicPager *pager = (GU_BasicPager *)param;
 
+  GU_Trace::event(GU_TRACE_PAGER_SWIPE, ev, indx, param, x, y, dx, dy);
+  GU_LATENCY_START(GU_LATENCY_SWIPE);
   pager->pager_swipe_cb(ev, indx, param, x, y, dx, dy);
+  GU_LATENCY_STOP(GU_LATENCY_SWIPE);
 }
 
 
@@ -80,14 +159,14 @@ void pager_swipe_wrapper(EventType ev, int indx, void *param, int x, int y, int
 
 // Pager (row of dots)
 
-// Init the pager's dots button, and call the base class for further
-// initialisation.
+// Take the event for the pager's dots button, and call the base class for
+// further initialisation.
 
 void GU_Pager::initPager(int n_pages, int first_page, DragCB callback, void *param, uint16_t fillcolor)
 {
   // Button used for selecting pages by tapping dots.
-  static GU_Button dots_button(NULL, _gd);
-  _dots_button = &dots_button;
+  if (_dots_slot < 0)
+    _dots_slot = GU_Slots::alloc();
 
   GU_BasicPager::initPager(n_pages, first_page, callback, param, fillcolor);
 }
@@ -95,7 +174,10 @@ void GU_Pager::initPager(int n_pages, int first_page, DragCB callback, void *par
 // Clear the page to fillcolor.
 void GU_Pager::clearPage(bool dots)
 {
-  _gfx->fillScreen(_fillcolor);
+  GU_FrameBuffer fb(_gfx);
+
+  GU_Stats::setWidget(this, GU_STATS_PAGER);
+  fb.fillRect(0, 0, _gfx->width(), _gfx->height(), _fillcolor);
   displayDots(dots);
 }
 
@@ -107,67 +189,254 @@ void dotsCB(EventType ev, int indx, void *param, int x, int y)
   uint16_t w, h;
   int dot;
 
+  GU_Trace::event(GU_TRACE_DOTS, ev, indx, param, x, y);
+  GU_LATENCY_START(GU_LATENCY_DOTS);
+
   // Decide which dot has been touched based on the x value.
-  pager->_dots_button->getButtonRect(&start_x, &start_y, &w, &h);
+  pager->_dots_button.getButtonRect(&start_x, &start_y, &w, &h);
   dot = (x - start_x) / (dotsize + spacing);
 
   // Issue a swipe CB to the caller to select which page to go to.
   if (dot != pager->_curr_page && dot < pager->_num_pages)
     pager->gotoPage(dot);
+  GU_LATENCY_STOP(GU_LATENCY_DOTS);
 }
 
 // Display the row of dots at bottom of screen with the current page highlighted.
 // Dot color is the bitwise negation of the fillcolor, so it shows up on any background.
 // Create an invisible button over the dots to pick up taps to select pages.
 // If dots is false, don't display the dots, and cancel the invisible button.
+// Its event is kept for when the dots come back, and only given back when
+// the pager is destroyed.
 void GU_Pager::displayDots(bool dots)
 {
   int radius = dotsize / 2;
   int x = (_gfx->width() / 2) - _num_pages * (dotsize + spacing) / 2;
   int y = _gfx->height() - dotsize - spacing;
-  if (dots)
+  GU_FrameBuffer fb(_gfx);
+
+  GU_Stats::setWidget(this, GU_STATS_PAGER);
+  if (dots && _dots_slot >= 0)
   {
     // Create the button. The callback will generate swipe callbacks to
     // tell the user to switch pages.
-    _dots_button->initButtonUL(x - radius, y - radius,
+    _dots_button.initButtonUL(x - radius, y - radius,
                             _num_pages * (dotsize + spacing), dotsize + spacing,
                             0, 0, 0, "\0", 1,
-                            dotsCB, MAX_EVENTS - 6, (void *)this);
+                            dotsCB, _dots_slot, (void *)this);
+
+    // Clear behind the dots, in case the page was restored from the cache
+    // with a different dot filled.
+    fb.fillRect(x - radius, y - radius, _num_pages * (dotsize + spacing), dotsize + 1, _fillcolor);
 
     // Draw the dots. The dot for the current page is filled.
     for (int i = 0; i < _num_pages; i++)
     {
       if (i == _curr_page)
-        _gfx->fillCircle(x, y, radius, ~_fillcolor);
+        fb.fillCircle(x, y, radius, ~_fillcolor);
       else
-        _gfx->drawCircle(x, y, radius, ~_fillcolor);
+        fb.drawCircle(x, y, radius, ~_fillcolor);
       x += dotsize + spacing;
     }
   }
-  else(x - radius, y - radius,
-                            _num_pages * (dotsize + spacing), dotsize + spacing,
-                            0, 0, 0, "\0", 1,
-                            dotsCB, MAX_EVENTS - 6, (void *)this);
+  else if (!dots)
   {
     // Cancel the button, since there are no dots.
-  _gd->cancelEvent(MAX_EVENTS - 6);
+    if (_dots_slot >= 0)
+      _gd->cancelEvent(_dots_slot);
+  }
+}
+
+// Give back the dots button's event as well as the swipe.
+void GU_Pager::freeSlots(void)
+{
+  if (_dots_slot >= 0)
+    _gd->cancelEvent(_dots_slot);
+  GU_Slots::free(_dots_slot);
+  _dots_slot = -1;
+  GU_BasicPager::freeSlots();
+}
+
+// Set up the page cache. The surfaces are allocated as they are needed.
+void GU_Pager::enableCache(uint32_t budget, RenderCB render, void *param)
+{
+  uint32_t page_bytes = (uint32_t)_gfx->width() * _gfx->height() * sizeof(uint16_t);
+
+  _n_cache = min(budget / page_bytes, (uint32_t)MAX_CACHED_PAGES);
+  for (int i = 0; i < MAX_CACHED_PAGES; i++)
+  {
+    _cache[i].page = -1;
+    _cache[i].last_used = 0;
+    GU_FrameBuffer::freePixels(_cache[i].pixels);
+    _cache[i].pixels = NULL;
+  }
+
+  _render = render;
+  _render_param = param;
+  if (_surface == NULL && _n_cache > 0)
+    _surface = new GU_Surface(_gfx->width(), _gfx->height());
+  else if (_surface != NULL && _n_cache == 0)
+  {
+    delete _surface;
+    _surface = NULL;
+  }
+}
+
+// The cached pages are screen-sized buffers in SDRAM, so give them back.
+GU_Pager::~GU_Pager()
+{
+  for (int i = 0; i < MAX_CACHED_PAGES; i++)
+    GU_FrameBuffer::freePixels(_cache[i].pixels);
+  delete _surface;
+}
+
+// Throw away a page, or all of them. The surfaces are kept for reuse.
+void GU_Pager::invalidatePage(int page)
+{
+  for (int i = 0; i < _n_cache; i++)
+  {
+    if (page < 0 || _cache[i].page == page)
+      _cache[i].page = -1;
+  }
+}
+
+// Find a page in the cache, or -1 if it's not there.
+int GU_Pager::findCachedPage(int page)
+{
+  for (int i = 0; i < _n_cache; i++)
+  {
+    if (_cache[i].page == page)
+      return i;
   }
+  return -1;
+}
+
+// Find a surface to hold a page. Use the page's own surface if it has one,
+// else an empty one, else throw out the least recently used page. The page on
+// the screen is never thrown out, and when rendering ahead neither are its
+// neighbours (or they would just take turns evicting each other).
+// Returns -1 if there is no surface to be had.
+int GU_Pager::allocCachedPage(int page, bool ahead)
+{
+  int c = findCachedPage(page);
+
+  if (c < 0)
+  {
+    for (int i = 0; i < _n_cache; i++)
+    {
+      if (_cache[i].page < 0)
+      {
+        c = i;
+        break;
+      }
+      if (_cache[i].page == _curr_page && page != _curr_page)
+        continue;
+      if (ahead && abs(_cache[i].page - _curr_page) <= 1)
+        continue;
+      if (c < 0 || _cache[i].last_used < _cache[c].last_used)
+        c = i;
+    }
+  }
+  if (c < 0)
+    return -1;
+
+  if (_cache[c].pixels == NULL)
+    _cache[c].pixels = GU_FrameBuffer::allocPixels((uint32_t)_gfx->width() * _gfx->height());
+  if (_cache[c].pixels == NULL)
+    return -1;
+
+  _cache[c].page = page;
+  _cache[c].last_used = ++_cache_clock;
+  return c;
+}
+
+// Save the page being left.
+void GU_Pager::leavePage(int page)
+{
+  GU_FrameBuffer fb(_gfx);
+  int c;
+
+  if (_n_cache == 0)
+    return;
+
+  c = allocCachedPage(page, false);
+  if (c >= 0)
+    fb.readRect(0, 0, _gfx->width(), _gfx->height(), _cache[c].pixels);
+}
+
+// Show a page from the cache if we have it, otherwise clear the page.
+void GU_Pager::enterPage(int page)
+{
+  GU_FrameBuffer fb(_gfx);
+  int c = findCachedPage(page);
+
+  GU_Stats::setWidget(this, GU_STATS_PAGER);
+  _restored = c >= 0;
+  if (_restored)
+  {
+    _cache[c].last_used = ++_cache_clock;
+    fb.writeRect(0, 0, _gfx->width(), _gfx->height(), _cache[c].pixels);
+    displayDots(true);
+  }
+  else
+  {
+    clearPage(true);
+  }
+}
+
+// Draw a strip of an incoming page. Take it from the cache if the page is
+// there (the dots are redrawn when it's entered), otherwise clear it.
+void GU_Pager::drawSlideStrip(int page, int16_t x, uint16_t w, int16_t src_x)
+{
+  GU_FrameBuffer fb(_gfx);
+  int c = findCachedPage(page);
+
+  GU_Stats::setWidget(this, GU_STATS_PAGER);
+  if (c >= 0)
+    fb.writeRect(x, 0, w, _gfx->height(), _cache[c].pixels + src_x, _gfx->width());
+  else
+    fb.fillRect(x, 0, w, _gfx->height(), _fillcolor);
+}
+
+// Draw a page off-screen using the user's render callback.
+void GU_Pager::renderPage(int page)
+{
+  int c = allocCachedPage(page, true);
+
+  if (c < 0)
+    return;
+
+  _surface->setPixels(_cache[c].pixels);
+  _surface->fillScreen(_fillcolor);
+  (*_render)(page, _surface, _render_param);
+}
+
+// Render one of the neighbouring pages if it isn't cached yet.
+void GU_Pager::idle(void)
+{
+  if (_render == NULL || _n_cache < 2)
+    return;
+
+  if (_curr_page > 0 && findCachedPage(_curr_page - 1) < 0)
+    renderPage(_curr_page - 1);
+  else if (_curr_page < _num_pages - 1 && findCachedPage(_curr_page + 1) < 0)
+    renderPage(_curr_page + 1);
 }
 
 // ---------------------------------------------------------------------------------
 
 // Sidebar pager.
 
-// Init the pager's cancel button, and call the base class for further
-// initialisation.
+// Take the event for the sidebar's cancel button, and call the base class
+// for further initialisation.
 
 void GU_Sidebar::initSidebar(int n_pages, int first_page,
                             uint16_t sidewidth, uint16_t sidecolor, uint16_t sideborder,
                             DragCB callback, void *param, uint16_t fillcolor)
 {
-  // Button used for selecting pages by tapping dots.
-  static GU_Button cancel_button(NULL, _gd);
-  _cancel_button = &cancel_button;
+  // Button used for going back to the main page.
+  if (_cancel_slot < 0)
+    _cancel_slot = GU_Slots::alloc();
 
   _main_page = first_page;
   _sidewidth = sidewidth;
@@ -183,52 +452,195 @@ void GU_Sidebar::clearPage(bool indicator)
 {
   int bar_w = 3;
   int bar_h = _gfx->height() / 3;
+  GU_FrameBuffer fb(_gfx);
 
+  GU_Stats::setWidget(this, GU_STATS_SIDEBAR);
   if (_curr_page == _main_page)
   {
     // We're on the main (full-screen) page. Clear it to fill color.
     // Display indicator(s) if there are sidebars on left or right.
     // There is no cancel button.
-    _gfx->fillScreen(_fillcolor);
+    fb.fillRect(0, 0, _gfx->width(), _gfx->height(), _fillcolor);
+    _dimmed = false;
     if (_curr_page > 0 && indicator)
-        _gfx->fillRect(5, bar_h, 3, bar_h, _sideborder);
+        fb.fillRect(5, bar_h, bar_w, bar_h, _sideborder);
     if (_curr_page < _num_pages - 1 && indicator)
-        _gfx->fillRect(_gfx->width() - 8, bar_h, 3, bar_h, _sideborder);
-    _gd->cancelEvent(MAX_EVENTS - 6);
+        fb.fillRect(_gfx->width() - 5 - bar_w, bar_h, bar_w, bar_h, _sideborder);
+    if (_cancel_slot >= 0)
+      _gd->cancelEvent(_cancel_slot);
   }
   else if (_curr_page < _main_page)
   {
     // We're in a sidebar on the left. Fill and outline it.
     // Display indicator on left if there are more sidebars to the left.
     // The remaining screen space to the right becomes the cancel button.
-    _gfx->fillRect(0, 0, _sidewidth, _gfx->height(), _sidecolor);
-    _gfx->drawRect(0, 0, _sidewidth, _gfx->height(), _sideborder);
+    if (_dim_behind > 0 && !_dimmed)
+      fb.blendRect(_sidewidth, 0, _gfx->width() - _sidewidth, _gfx->height(), BLACK, _dim_behind);
+    _dimmed = true;
+    fb.fillRect(0, 0, _sidewidth, _gfx->height(), _sidecolor);
+    fb.drawRect(0, 0, _sidewidth, _gfx->height(), _sideborder);
     if (_curr_page > 0 && indicator)
-        _gfx->fillRect(5, bar_h, 3, bar_h, _sideborder);
-    _cancel_button->initButtonUL(_sidewidth, 0,
-                            _gfx->width() - _sidewidth - 1, _gfx->height(),
-                            0, 0, 0, "\0", 1,
-                            cancelCB, MAX_EVENTS - 6, (void *)this);
+        fb.fillRect(5, bar_h, bar_w, bar_h, _sideborder);
+    if (_cancel_slot >= 0)
+      _cancel_button.initButtonUL(_sidewidth, 0,
+                              _gfx->width() - _sidewidth - 1, _gfx->height(),
+                              0, 0, 0, "\0", 1,
+                              cancelCB, _cancel_slot, (void *)this);
   }
   else if (_curr_page >_main_page)
   {
     // We're in a sidebar on the right. Fill and outline it.
     // Display indicator on right if there are more sidebars to the right.
     // The remaining screen space to the left becomes the cancel button.
-    _gfx->fillRect(_gfx->width() - _sidewidth - 1, 0, _sidewidth, _gfx->height(), _sidecolor);
-    _gfx->drawRect(_gfx->width() - _sidewidth - 1, 0, _sidewidth, _gfx->height(), _sideborder);
+    if (_dim_behind > 0 && !_dimmed)
+    {
+      fb.blendRect(0, 0, _gfx->width() - _sidewidth - 1, _gfx->height(), BLACK, _dim_behind);
+      fb.blendRect(_gfx->width() - 1, 0, 1, _gfx->height(), BLACK, _dim_behind);
+    }
+    _dimmed = true;
+    fb.fillRect(_gfx->width() - _sidewidth - 1, 0, _sidewidth, _gfx->height(), _sidecolor);
+    fb.drawRect(_gfx->width() - _sidewidth - 1, 0, _sidewidth, _gfx->height(), _sideborder);
     if (_curr_page < _num_pages - 1 && indicator)
-        _gfx->fillRect(_gfx->width() - 8, bar_h, 3, bar_h, _sideborder);
-    _cancel_button->initButtonUL(0, 0,
-                            _gfx->width() - _sidewidth - 1, _gfx->height(),
-                            0, 0, 0, "\0", 1,
-                            cancelCB, MAX_EVENTS - 6, (void *)this);
+        fb.fillRect(_gfx->width() - 5 - bar_w, bar_h, bar_w, bar_h, _sideborder);
+    if (_cancel_slot >= 0)
+      _cancel_button.initButtonUL(0, 0,
+                              _gfx->width() - _sidewidth - 1, _gfx->height(),
+                              0, 0, 0, "\0", 1,
+                              cancelCB, _cancel_slot, (void *)this);
+  }
+
+  // If we're leaving the pager altogether, make sure that button gets
+  // canceled. Its event is given back when the pager is destroyed.
+  if (!indicator && _cancel_slot >= 0)
+    _gd->cancelEvent(_cancel_slot);
+}
+
+// Give back the cancel button's event as well as the swipe.
+void GU_Sidebar::freeSlots(void)
+{
+  if (_cancel_slot >= 0)
+    _gd->cancelEvent(_cancel_slot);
+  GU_Slots::free(_cancel_slot);
+  _cancel_slot = -1;
+  GU_BasicPager::freeSlots();
+}
+
+// Slide a sidebar on over the main page, or off it again. The band under the
+// sidebar is saved as it comes on, so only the sidebar moves, and what it
+// covered is put back as it goes off. Going between sidebars is done in
+// one go.
+bool GU_Sidebar::slidePage(int from, int to)
+{
+  int side = (from == _main_page) ? to : from;
+  int16_t x = (side < _main_page) ? 0 : _gfx->width() - _sidewidth - 1;
+  bool ok;
+
+  if (from != _main_page && to != _main_page)
+    return false;
+
+  if (to != _main_page)
+  {
+    GU_FrameBuffer fb(_gfx);
+
+    if (_under == NULL)
+      _under = GU_FrameBuffer::allocPixels((uint32_t)_sidewidth * _gfx->height());
+    if (_under == NULL)
+      return false;
+    fb.readRect(x, 0, _sidewidth, _gfx->height(), _under);
+    return slideSidebar(x, side, side < _main_page, true);
+  }
+
+  // Going off. Without a saved band (the sidebar came on in one go), the
+  // main page is just drawn again.
+  ok = _under != NULL && slideSidebar(x, side, side < _main_page, false);
+  GU_FrameBuffer::freePixels(_under);
+  _under = NULL;
+  return ok;
+}
+
+// Move the sidebar's pixels along a step each frame, drawing the strip of it
+// that comes into view, or putting back the strip of the saved band that it
+// uncovers. A left sidebar's right edge leads; a right sidebar's left edge.
+// Frames are paced as they are for the pager.
+bool GU_Sidebar::slideSidebar(int16_t x, int side, bool left, bool opening)
+{
+  GU_FrameBuffer fb(_gfx);
+  uint16_t w = _sidewidth;
+  uint16_t h = _gfx->height();
+  int16_t shown = opening ? 0 : w;    // columns of the sidebar on the screen
+
+  GU_Stats::setWidget(this, GU_STATS_SIDEBAR);
+  if (!fb.isValid())
+    return false;
+
+  for (int k = 1; k <= _slide_frames; k++)
+  {
+    unsigned long start = GU_Trace::now();
+    int16_t v = (int32_t)w * k / _slide_frames;
+    int16_t step;
+
+    if (!opening)
+      v = w - v;
+    step = abs(v - shown);
+
+    if (left && opening)
+    {
+      fb.moveRect(x, 0, shown, h, step, 0);
+      drawSlideStrip(side, x, step, w - v);
+    }
+    else if (left)
+    {
+      fb.moveRect(x + step, 0, v, h, -step, 0);
+      drawSlideStrip(_main_page, x + v, step, v);
+    }
+    else if (opening)
+    {
+      fb.moveRect(x + w - shown, 0, shown, h, -step, 0);
+      drawSlideStrip(side, x + w - step, step, shown);
+    }
+    else
+    {
+      fb.moveRect(x + w - shown, 0, v, h, step, 0);
+      drawSlideStrip(_main_page, x + w - shown, step, w - shown);
+    }
+    shown = v;
+
+    if (GU_Trace::now() - start > _slide_ms)
+      return false;
+    while (GU_Trace::now() - start < _slide_ms)
+      GU_Trace::wait(1);
+  }
+  return true;
+}
+
+// Draw a strip of the band under the sidebar. For the main page it's put back
+// from the saved band. For a sidebar, it's the part of its fill and outline
+// that is in the strip (clearPage draws the indicators when the sidebar has
+// finished sliding on).
+void GU_Sidebar::drawSlideStrip(int page, int16_t x, uint16_t w, int16_t src_x)
+{
+  GU_FrameBuffer fb(_gfx);
+  int16_t h = _gfx->height();
+
+  GU_Stats::setWidget(this, GU_STATS_SIDEBAR);
+  if (w == 0)
+    return;
+  if (page == _main_page)
+  {
+    if (_under != NULL)
+      fb.writeRect(x, 0, w, h, _under + src_x, _sidewidth);
+    else
+      fb.fillRect(x, 0, w, h, _fillcolor);
+    return;
   }
 
-  // If we're leaving the pager altogether, make sure that button
-  // gets canceled.
-  if (!indicator)
-    _gd->cancelEvent(MAX_EVENTS - 6);
+  fb.fillRect(x, 0, w, h, _sidecolor);
+  fb.drawFastHLine(x, 0, w, _sideborder);
+  fb.drawFastHLine(x, h - 1, w, _sideborder);
+  if (src_x == 0)
+    fb.drawFastVLine(x, 0, h, _sideborder);
+  if (src_x + w == _sidewidth)
+    fb.drawFastVLine(x + w - 1, 0, h, _sideborder);
 }
 
 // Cancel button callback. Return to the main page.
@@ -236,5 +648,6 @@ void cancelCB(EventType ev, int indx, void *param, int x, int y)
 {
   GU_Sidebar *pager = (GU_Sidebar *)param;
 
+  GU_Trace::event(GU_TRACE_SIDEBAR_CANCEL, ev, indx, param, x, y);
   pager->gotoPage(pager->_main_page);
 }
\ No newline at end of file
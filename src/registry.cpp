@@ -0,0 +1,253 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+
+// Registry of sensitive areas, with taps routed through a grid.
+
+// Empty the registry: no areas, all cells empty, all entries free.
+void GU_Registry::clear(void)
+{
+  for (int i = 0; i < MAX_REGISTERED; i++)
+    _areas[i].callback = NULL;
+  for (int i = 0; i < GRID_ROWS * GRID_COLS; i++)
+    _cells[i] = -1;
+  for (int i = 0; i < MAX_GRID_ENTRIES - 1; i++)
+    _entries[i].next = i + 1;
+  _entries[MAX_GRID_ENTRIES - 1].next = -1;
+  _free_entry = 0;
+  _pressed = -1;
+  _n_catchall = 0;
+  setBounds(0, 0, 0, 0);
+}
+
+// Start routing taps from the event at indx. It only covers the areas,
+// so it is not registered until there are some.
+void GU_Registry::initRegistry(int indx)
+{
+  clear();
+  _indx = indx;
+}
+
+// Set the extent of the areas (x2/y2 exclusive, empty if x1 == x2), and
+// make the event in GestureDetector cover it. A catch-all area widens it
+// to the whole screen, as does a zero size event in GestureDetector.
+void GU_Registry::setBounds(int x1, int y1, int x2, int y2)
+{
+  _bx1 = x1;
+  _by1 = y1;
+  _bx2 = x2;
+  _by2 = y2;
+  if (_indx < 0)
+    return;
+
+  if (_n_catchall > 0)
+    _gd->onTap(0, 0, 0, 0, registry_tap_wrapper, _indx, (void *)this);
+  else if (x1 >= x2 || y1 >= y2)
+    _gd->cancelEvent(_indx);
+  else
+    _gd->onTap(x1, y1, x2 - x1, y2 - y1, registry_tap_wrapper, _indx, (void *)this);
+}
+
+void GU_Registry::destroyRegistry(void)
+{
+  if (_indx >= 0)
+    _gd->cancelEvent(_indx);
+  _indx = -1;
+  clear();
+}
+
+// Get the range of cells covered by an area, clipped to the grid.
+void GU_Registry::cellRange(int i, int *c1, int *r1, int *c2, int *r2)
+{
+  GU_Area *a = &_areas[i];
+
+  *c1 = max(0, a->x / GRID_CELL_SIZE);
+  *r1 = max(0, a->y / GRID_CELL_SIZE);
+  *c2 = min(GRID_COLS - 1, (a->x + a->w - 1) / GRID_CELL_SIZE);
+  *r2 = min(GRID_ROWS - 1, (a->y + a->h - 1) / GRID_CELL_SIZE);
+}
+
+// Register an area, adding it to each cell it covers. Catch-all areas
+// (zero size) aren't put in any cell.
+bool GU_Registry::onTap(int x, int y, int w, int h, TapCB callback, int indx, void *param)
+{
+  int c1, r1, c2, r2;
+
+  if (indx < 0 || indx >= MAX_REGISTERED || callback == NULL)
+    return false;
+
+  cancelEvent(indx);
+  _areas[indx].x = x;
+  _areas[indx].y = y;
+  _areas[indx].w = w;
+  _areas[indx].h = h;
+  _areas[indx].param = param;
+
+  if (w == 0 || h == 0)
+  {
+    _n_catchall++;
+  }
+  else
+  {
+    cellRange(indx, &c1, &r1, &c2, &r2);
+    for (int r = r1; r <= r2; r++)
+    {
+      for (int c = c1; c <= c2; c++)
+      {
+        int e = _free_entry;
+
+        if (e < 0)
+        {
+          // Out of entries. Take out the ones already added, and fail.
+          _areas[indx].callback = callback;
+          cancelEvent(indx);
+          return false;
+        }
+        _free_entry = _entries[e].next;
+        _entries[e].area = indx;
+        _entries[e].next = _cells[r * GRID_COLS + c];
+        _cells[r * GRID_COLS + c] = e;
+      }
+    }
+  }
+
+  _areas[indx].callback = callback;
+
+  // Grow the extent to take in the new area.
+  if (w == 0 || h == 0)
+    setBounds(_bx1, _by1, _bx2, _by2);
+  else if (_bx1 >= _bx2 || _by1 >= _by2)
+    setBounds(x, y, x + w, y + h);
+  else
+    setBounds(min(_bx1, x), min(_by1, y), max(_bx2, x + w), max(_by2, y + h));
+  return true;
+}
+
+// Cancel an area, taking it out of the cells it covers, and shrink the
+// extent to the areas that are left.
+void GU_Registry::cancelEvent(int indx)
+{
+  int x1 = 0, y1 = 0, x2 = 0, y2 = 0;
+
+  if (indx < 0 || indx >= MAX_REGISTERED || _areas[indx].callback == NULL)
+    return;
+
+  _areas[indx].callback = NULL;
+  if (_pressed == indx)
+    _pressed = -1;
+  if (_areas[indx].w == 0 || _areas[indx].h == 0)
+    _n_catchall--;
+  else
+    removeEntries(indx);
+
+  for (int i = 0; i < MAX_REGISTERED; i++)
+  {
+    GU_Area *a = &_areas[i];
+
+    if (a->callback == NULL || a->w == 0 || a->h == 0)
+      continue;
+    if (x1 >= x2)
+    {
+      x1 = a->x;
+      y1 = a->y;
+      x2 = a->x + a->w;
+      y2 = a->y + a->h;
+    }
+    else
+    {
+      x1 = min(x1, (int)a->x);
+      y1 = min(y1, (int)a->y);
+      x2 = max(x2, a->x + a->w);
+      y2 = max(y2, a->y + a->h);
+    }
+  }
+  setBounds(x1, y1, x2, y2);
+}
+
+// Take an area out of the cells it covers.
+void GU_Registry::removeEntries(int indx)
+{
+  int c1, r1, c2, r2;
+
+  cellRange(indx, &c1, &r1, &c2, &r2);
+  for (int r = r1; r <= r2; r++)
+  {
+    for (int c = c1; c <= c2; c++)
+    {
+      int16_t *link = &_cells[r * GRID_COLS + c];
+
+      while (*link >= 0)
+      {
+        int e = *link;
+
+        if (_entries[e].area == indx)
+        {
+          *link = _entries[e].next;
+          _entries[e].next = _free_entry;
+          _free_entry = e;
+        }
+        else
+        {
+          link = &_entries[e].next;
+        }
+      }
+    }
+  }
+}
+
+// Find the highest priority area containing x/y. Only the cell x/y is in
+// needs to be looked at. Failing that, look for a catch-all area.
+int GU_Registry::hitTest(int x, int y)
+{
+  int found = -1;
+  int c = x / GRID_CELL_SIZE;
+  int r = y / GRID_CELL_SIZE;
+
+  if (x >= 0 && y >= 0 && c < GRID_COLS && r < GRID_ROWS)
+  {
+    for (int e = _cells[r * GRID_COLS + c]; e >= 0; e = _entries[e].next)
+    {
+      GU_Area *a = &_areas[_entries[e].area];
+
+      if (_entries[e].area > found
+          && x >= a->x && x < a->x + a->w && y >= a->y && y < a->y + a->h)
+        found = _entries[e].area;
+    }
+  }
+  if (found >= 0 || _n_catchall == 0)
+    return found;
+
+  for (int i = MAX_REGISTERED - 1; i >= 0; i--)
+  {
+    if (_areas[i].callback != NULL && (_areas[i].w == 0 || _areas[i].h == 0))
+      return i;
+  }
+  return -1;
+}
+
+// Route a tap to the area under it. The release goes to the area that got
+// the press, so each area sees a matching press and release.
+void GU_Registry::registry_tap_cb(EventType ev, int indx, void *param, int x, int y)
+{
+  int i;
+
+  if (ev & EV_RELEASED)
+  {
+    i = _pressed >= 0 ? _pressed : hitTest(x, y);
+    _pressed = -1;
+  }
+  else
+  {
+    i = _pressed = hitTest(x, y);
+  }
+
+  if (i >= 0)
+    (*_areas[i].callback)(ev, i, _areas[i].param, x, y);
+}
+
+void registry_tap_wrapper(EventType ev, int indx, void *param, int x, int y)
+{
+  GU_Registry *reg = (GU_Registry *)param;
+
+  GU_Trace::event(GU_TRACE_REGISTRY_TAP, ev, indx, param, x, y);
+  reg->registry_tap_cb(ev, indx, param, x, y);
+}
@@ -0,0 +1,271 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+#ifdef ARDUINO_ARCH_MBED
+#include "mbed.h"
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+// Render queue.
+
+GU_RenderQueue::GU_RenderCommand GU_RenderQueue::_queue[GU_RENDER_QUEUE_SIZE];
+std::atomic<uint32_t> GU_RenderQueue::_head(0);
+std::atomic<uint32_t> GU_RenderQueue::_tail(0);
+uint32_t GU_RenderQueue::_posted = 0;
+uint32_t GU_RenderQueue::_dropped = 0;
+
+static GestureDetector *render_gd;
+static RedrawCB render_idle;
+static void *render_param;
+static std::atomic<bool> render_stop(false);
+
+#ifdef ARDUINO_ARCH_MBED
+static rtos::Thread *render_thread = NULL;
+
+#define RENDER_WAKE   1     // thread flag set when the queue stops being empty
+#else
+// Elsewhere (the host build) the thread is a std::thread, woken through a
+// condition variable.
+static std::thread *render_thread = NULL;
+static std::mutex render_mutex;
+static std::condition_variable render_cv;
+static bool render_wake = false;
+#endif
+
+// Find room for n changes, or return NULL (and count them as dropped) if
+// there isn't any. Only the consumer moves the tail, and only ever on, so
+// there is at least this much room until they are published.
+GU_RenderQueue::GU_RenderCommand *GU_RenderQueue::reserve(int n)
+{
+  uint32_t head = _head.load(std::memory_order_relaxed);
+
+  if (GU_RENDER_QUEUE_SIZE - (head - _tail.load(std::memory_order_acquire)) < (uint32_t)n)
+  {
+    _dropped += n;
+    return NULL;
+  }
+  return &_queue[head % GU_RENDER_QUEUE_SIZE];
+}
+
+// Hand a filled-in change to the consumer. The release makes sure it sees
+// the contents along with the new head. If the queue was empty, the thread
+// may be waiting, so wake it. The fence keeps the load of the tail after the
+// store of the head; drain() has the matching one, so either the consumer
+// sees the new head or this sees the tail it last stored.
+void GU_RenderQueue::publish(GU_RenderCommand *cmd, int kind, void *element)
+{
+  uint32_t head = _head.load(std::memory_order_relaxed);
+
+  cmd->kind = kind;
+  cmd->element = element;
+  cmd->posted = micros();
+  _head.store(head + 1, std::memory_order_release);
+  _posted++;
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (render_thread != NULL && head == _tail.load(std::memory_order_acquire))
+    wakeThread();
+}
+
+bool GU_RenderQueue::setText(GU_BasicButton *button, char *label)
+{
+  GU_RenderCommand *cmd = reserve(1);
+
+  if (cmd == NULL)
+    return false;
+  strncpy(cmd->text, label, GU_RENDER_TEXT_LEN - 1);
+  cmd->text[GU_RENDER_TEXT_LEN - 1] = '\0';
+  publish(cmd, GU_RENDER_SET_TEXT, button);
+  return true;
+}
+
+bool GU_RenderQueue::setColor(GU_BasicButton *button, uint16_t outline, uint16_t fill, uint16_t textcolor)
+{
+  GU_RenderCommand *cmd = reserve(1);
+
+  if (cmd == NULL)
+    return false;
+  cmd->colors[0] = outline;
+  cmd->colors[1] = fill;
+  cmd->colors[2] = textcolor;
+  publish(cmd, GU_RENDER_SET_COLOR, button);
+  return true;
+}
+
+bool GU_RenderQueue::setValue(GU_ProgressBar *bar, int32_t value)
+{
+  GU_RenderCommand *cmd = reserve(1);
+
+  if (cmd == NULL)
+    return false;
+  cmd->value = value;
+  publish(cmd, GU_RENDER_SET_VALUE, bar);
+  return true;
+}
+
+// The room is found for all the samples first, so a block is never
+// half posted.
+bool GU_RenderQueue::addSamples(GU_StripChart *chart, const int16_t *values, int n)
+{
+  int n_cmds = (n + GU_RENDER_SAMPLES - 1) / GU_RENDER_SAMPLES;
+
+  if (n <= 0)
+    return true;
+  if (reserve(n_cmds) == NULL)
+    return false;
+
+  while (n > 0)
+  {
+    GU_RenderCommand *cmd = &_queue[_head.load(std::memory_order_relaxed) % GU_RENDER_QUEUE_SIZE];
+    int k = min(n, GU_RENDER_SAMPLES);
+
+    memcpy(cmd->samples, values, k * sizeof(int16_t));
+    cmd->n = k;
+    publish(cmd, GU_RENDER_ADD_SAMPLES, chart);
+    values += k;
+    n -= k;
+  }
+  return true;
+}
+
+bool GU_RenderQueue::redraw(void *element, RedrawCB redraw)
+{
+  GU_RenderCommand *cmd = reserve(1);
+
+  if (cmd == NULL)
+    return false;
+  cmd->redraw = redraw;
+  publish(cmd, GU_RENDER_REDRAW, element);
+  return true;
+}
+
+void GU_RenderQueue::run(GU_RenderCommand *cmd)
+{
+  switch (cmd->kind)
+  {
+  case GU_RENDER_SET_TEXT:
+    ((GU_BasicButton *)cmd->element)->setText(cmd->text);
+    break;
+  case GU_RENDER_SET_COLOR:
+    ((GU_BasicButton *)cmd->element)->setColor(cmd->colors[0], cmd->colors[1], cmd->colors[2]);
+    break;
+  case GU_RENDER_SET_VALUE:
+    ((GU_ProgressBar *)cmd->element)->setValue(cmd->value);
+    break;
+  case GU_RENDER_ADD_SAMPLES:
+    ((GU_StripChart *)cmd->element)->addSamples(cmd->samples, cmd->n);
+    break;
+  case GU_RENDER_REDRAW:
+    (*cmd->redraw)(cmd->element);
+    break;
+  }
+}
+
+// Move the tail on after each change, so the producer gets the room back
+// as soon as possible.
+int GU_RenderQueue::drain(void)
+{
+  uint32_t tail = _tail.load(std::memory_order_relaxed);
+  uint32_t head = _head.load(std::memory_order_acquire);
+  int n = 0;
+
+  while (tail != head)
+  {
+    GU_RenderCommand *cmd = &_queue[tail % GU_RENDER_QUEUE_SIZE];
+
+    run(cmd);
+    GU_LATENCY_RECORD(GU_LATENCY_QUEUE, micros() - cmd->posted);
+    _tail.store(++tail, std::memory_order_release);
+    n++;
+
+    // Pick up anything posted while these were being made. The fence
+    // pairs with the one in publish(), so a change posted as the queue
+    // empties is either seen here or wakes the thread.
+    if (tail == head)
+    {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      head = _head.load(std::memory_order_acquire);
+    }
+  }
+  return n;
+}
+
+// Wake the thread if it is waiting.
+void GU_RenderQueue::wakeThread(void)
+{
+#ifdef ARDUINO_ARCH_MBED
+  render_thread->flags_set(RENDER_WAKE);
+#else
+  {
+    std::lock_guard<std::mutex> lock(render_mutex);
+    render_wake = true;
+  }
+  render_cv.notify_one();
+#endif
+}
+
+// Wait to be woken by a change, or until it's time to poll for touches.
+static void render_wait(void)
+{
+#ifdef ARDUINO_ARCH_MBED
+  rtos::ThisThread::flags_wait_any_for(RENDER_WAKE, std::chrono::milliseconds(GU_RENDER_POLL_MS));
+#else
+  std::unique_lock<std::mutex> lock(render_mutex);
+
+  render_cv.wait_for(lock, std::chrono::milliseconds(GU_RENDER_POLL_MS), [] { return render_wake; });
+  render_wake = false;
+#endif
+}
+
+static void render_loop(void)
+{
+  while (!render_stop.load())
+  {
+    render_wait();
+    if (render_gd != NULL)
+      render_gd->poll();
+    if (render_idle != NULL)
+      (*render_idle)(render_param);
+    GU_RenderQueue::drain();
+    GU_Frame::tick();
+  }
+}
+
+bool GU_RenderQueue::startThread(GestureDetector *gd, RedrawCB idle, void *param)
+{
+  if (render_thread != NULL)
+    return true;
+
+  render_gd = gd;
+  render_idle = idle;
+  render_param = param;
+  render_stop = false;
+#ifdef ARDUINO_ARCH_MBED
+  render_thread = new rtos::Thread(osPriorityNormal, GU_RENDER_STACK);
+  if (render_thread->start(mbed::callback(render_loop)) != osOK)
+  {
+    delete render_thread;
+    render_thread = NULL;
+    return false;
+  }
+#else
+  render_thread = new std::thread(render_loop);
+#endif
+  return true;
+}
+
+// Let the thread finish what it is doing, and wait for it to end.
+void GU_RenderQueue::stopThread(void)
+{
+  if (render_thread == NULL)
+    return;
+
+  render_stop = true;
+  wakeThread();
+  render_thread->join();
+  delete render_thread;
+  render_thread = NULL;
+}
@@ -0,0 +1,246 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+
+// RGB565 color arithmetic.
+//
+// The span functions work on two pixels at a time, loaded and stored as one
+// 32-bit word. (The Cortex-M7 has no NEON, and its DSP instructions work on
+// bytes and halfwords, which don't line up with the 5-6-5 fields.)
+// For the blends, each pixel is spread out as 00000GGG GGG00000 RRRRR000 00011111
+// so that a multiply by a 5-bit alpha scales all three fields at once without
+// them running into each other. A pixel at an odd halfword address at the
+// start, and one left over at the end, are done on their own.
+//
+// Where there is SSE2 (the host build on x86), runs of 8 pixels are done
+// first in 16-bit lanes, one field at a time, giving the same results. There
+// is no NEON path, as no board or host this is built for has NEON.
+
+#define SPREAD_MASK 0x07E0F81F
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+
+// Blend the fields of 8 pixels: (a * alpha + b * beta) >> 5 for each.
+static inline __m128i blend8(__m128i a, __m128i b, __m128i alpha, __m128i beta)
+{
+  const __m128i m6 = _mm_set1_epi16(0x3F);
+  const __m128i m5 = _mm_set1_epi16(0x1F);
+  __m128i r = _mm_add_epi16(_mm_mullo_epi16(_mm_srli_epi16(a, 11), alpha),
+                            _mm_mullo_epi16(_mm_srli_epi16(b, 11), beta));
+  __m128i g = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(a, 5), m6), alpha),
+                            _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(b, 5), m6), beta));
+  __m128i bl = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(a, m5), alpha),
+                             _mm_mullo_epi16(_mm_and_si128(b, m5), beta));
+
+  r = _mm_slli_epi16(_mm_srli_epi16(r, 5), 11);
+  g = _mm_slli_epi16(_mm_srli_epi16(g, 5), 5);
+  bl = _mm_srli_epi16(bl, 5);
+  return _mm_or_si128(r, _mm_or_si128(g, bl));
+}
+#endif
+
+// A pair of pixels. It may alias the uint16_t pixels it is loaded from.
+typedef uint32_t __attribute__((__may_alias__)) rgb565_pair;
+
+static inline uint32_t spread(uint16_t color)
+{
+  return (color | ((uint32_t)color << 16)) & SPREAD_MASK;
+}
+
+static inline uint16_t unspread(uint32_t x)
+{
+  x &= SPREAD_MASK;
+  return x | (x >> 16);
+}
+
+static inline bool odd_address(const uint16_t *p)
+{
+  return ((uintptr_t)p & 2) != 0;
+}
+
+// Pack and unpack a RGB565 color.
+void rgb565_unpack(uint16_t color, uint8_t *red, uint8_t *green, uint8_t *blue)
+{
+  *red = (color >> 8) & 0xF8;
+  *green = (color >> 3) & 0xFC;
+  *blue = (color << 3) & 0xF8;
+}
+
+uint16_t rgb565_pack(uint8_t red, uint8_t green, uint8_t blue)
+{
+  return ((red & 0xF8) << 8) | ((green & 0xFC) << 3) | (blue >> 3);
+}
+
+// Take the average of two RGB565 colors. Clearing the low bit of each field
+// before halving stops it shifting into the field below.
+uint16_t rgb565_average(uint16_t color1, uint16_t color2)
+{
+  return (color1 & color2) + (((color1 ^ color2) & 0xF7DE) >> 1);
+}
+
+// Blend color1 over color2.
+uint16_t rgb565_blend(uint16_t color1, uint16_t color2, uint8_t alpha)
+{
+  return unspread((spread(color1) * alpha + spread(color2) * (RGB565_ALPHA_MAX - alpha)) >> 5);
+}
+
+void rgb565_average_span(uint16_t *dst, const uint16_t *src, int n)
+{
+#ifdef __SSE2__
+  const __m128i mask = _mm_set1_epi16((short)0xF7DE);
+
+  for (; n >= 8; n -= 8, dst += 8, src += 8)
+  {
+    __m128i d = _mm_loadu_si128((const __m128i *)dst);
+    __m128i s = _mm_loadu_si128((const __m128i *)src);
+
+    d = _mm_add_epi16(_mm_and_si128(d, s), _mm_srli_epi16(_mm_and_si128(_mm_xor_si128(d, s), mask), 1));
+    _mm_storeu_si128((__m128i *)dst, d);
+  }
+#endif
+
+  if (n > 0 && odd_address(dst))
+  {
+    *dst = rgb565_average(*dst, *src++);
+    dst++;
+    n--;
+  }
+  if (odd_address(src))
+  {
+    // Can't load pairs from both; do them one at a time.
+    for (; n > 0; n--, dst++)
+      *dst = rgb565_average(*dst, *src++);
+    return;
+  }
+
+  rgb565_pair *d = (rgb565_pair *)dst;
+  const rgb565_pair *s = (const rgb565_pair *)src;
+
+  for (; n >= 2; n -= 2, d++, s++)
+    *d = (*d & *s) + (((*d ^ *s) & 0xF7DEF7DE) >> 1);
+  if (n > 0)
+    *(uint16_t *)d = rgb565_average(*(uint16_t *)d, *(const uint16_t *)s);
+}
+
+void rgb565_blend_span(uint16_t *dst, const uint16_t *src, int n, uint8_t alpha)
+{
+  uint8_t beta = RGB565_ALPHA_MAX - alpha;
+
+#ifdef __SSE2__
+  for (; n >= 8; n -= 8, dst += 8, src += 8)
+  {
+    __m128i d = _mm_loadu_si128((const __m128i *)dst);
+    __m128i s = _mm_loadu_si128((const __m128i *)src);
+
+    _mm_storeu_si128((__m128i *)dst, blend8(s, d, _mm_set1_epi16(alpha), _mm_set1_epi16(beta)));
+  }
+#endif
+
+  if (n > 0 && odd_address(dst))
+  {
+    *dst = rgb565_blend(*src++, *dst, alpha);
+    dst++;
+    n--;
+  }
+  if (odd_address(src))
+  {
+    for (; n > 0; n--, dst++)
+      *dst = rgb565_blend(*src++, *dst, alpha);
+    return;
+  }
+
+  rgb565_pair *d = (rgb565_pair *)dst;
+  const rgb565_pair *s = (const rgb565_pair *)src;
+
+  for (; n >= 2; n -= 2, d++, s++)
+  {
+    uint32_t dd = *d;
+    uint32_t ss = *s;
+    uint16_t lo = unspread((spread(ss) * alpha + spread(dd) * beta) >> 5);
+    uint16_t hi = unspread((spread(ss >> 16) * alpha + spread(dd >> 16) * beta) >> 5);
+
+    *d = lo | ((uint32_t)hi << 16);
+  }
+  if (n > 0)
+    *(uint16_t *)d = rgb565_blend(*(const uint16_t *)s, *(uint16_t *)d, alpha);
+}
+
+void rgb565_mix_span(uint16_t *dst, int n, uint16_t color, uint8_t alpha)
+{
+  uint32_t c = spread(color) * alpha;   // the same for every pixel
+  uint8_t beta = RGB565_ALPHA_MAX - alpha;
+
+#ifdef __SSE2__
+  for (; n >= 8; n -= 8, dst += 8)
+  {
+    __m128i d = _mm_loadu_si128((const __m128i *)dst);
+
+    _mm_storeu_si128((__m128i *)dst, blend8(_mm_set1_epi16(color), d,
+                                            _mm_set1_epi16(alpha), _mm_set1_epi16(beta)));
+  }
+#endif
+
+  if (n > 0 && odd_address(dst))
+  {
+    *dst = unspread((c + spread(*dst) * beta) >> 5);
+    dst++;
+    n--;
+  }
+
+  rgb565_pair *d = (rgb565_pair *)dst;
+
+  for (; n >= 2; n -= 2, d++)
+  {
+    uint32_t dd = *d;
+    uint16_t lo = unspread((c + spread(dd) * beta) >> 5);
+    uint16_t hi = unspread((c + spread(dd >> 16) * beta) >> 5);
+
+    *d = lo | ((uint32_t)hi << 16);
+  }
+  if (n > 0)
+    *(uint16_t *)d = unspread((c + spread(*(uint16_t *)d) * beta) >> 5);
+}
+
+void rgb565_darken_span(uint16_t *dst, int n, uint8_t amount)
+{
+  uint8_t beta = RGB565_ALPHA_MAX - amount;
+
+#ifdef __SSE2__
+  for (; n >= 8; n -= 8, dst += 8)
+  {
+    __m128i d = _mm_loadu_si128((const __m128i *)dst);
+
+    _mm_storeu_si128((__m128i *)dst, blend8(_mm_setzero_si128(), d,
+                                            _mm_setzero_si128(), _mm_set1_epi16(beta)));
+  }
+#endif
+
+  if (n > 0 && odd_address(dst))
+  {
+    *dst = unspread((spread(*dst) * beta) >> 5);
+    dst++;
+    n--;
+  }
+
+  rgb565_pair *d = (rgb565_pair *)dst;
+
+  if (amount == RGB565_ALPHA_MAX / 2)
+  {
+    // Halving is just a shift, keeping each field's top bit out of the one below.
+    for (; n >= 2; n -= 2, d++)
+      *d = (*d >> 1) & 0x7BEF7BEF;
+  }
+  else
+  {
+    for (; n >= 2; n -= 2, d++)
+    {
+      uint32_t dd = *d;
+      uint16_t lo = unspread((spread(dd) * beta) >> 5);
+      uint16_t hi = unspread((spread(dd >> 16) * beta) >> 5);
+
+      *d = lo | ((uint32_t)hi << 16);
+    }
+  }
+  if (n > 0)
+    *(uint16_t *)d = unspread((spread(*(uint16_t *)d) * beta) >> 5);
+}
@@ -0,0 +1,29 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+
+// Event slots, held as a bitmap of the band.
+
+uint32_t GU_Slots::_used = 0;
+
+// The lowest free slot is the lowest clear bit.
+int GU_Slots::alloc(void)
+{
+  uint32_t free_bits = ~_used;
+  int n;
+
+  if (GU_SLOTS_BAND < 32)
+    free_bits &= (1UL << GU_SLOTS_BAND) - 1;
+  if (free_bits == 0)
+    return -1;
+
+  n = __builtin_ctz(free_bits);
+  _used |= 1UL << n;
+  return GU_SLOTS_FIRST + n;
+}
+
+void GU_Slots::free(int indx)
+{
+  if (indx < GU_SLOTS_FIRST || indx >= GU_SLOTS_FIRST + GU_SLOTS_BAND)
+    return;
+  _used &= ~(1UL << (indx - GU_SLOTS_FIRST));
+}
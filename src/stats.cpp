@@ -0,0 +1,191 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+#include <SDRAM.h>
+
+// Pixel write statistics.
+
+Adafruit_GFX *GU_Stats::_gfx = NULL;
+uint16_t *GU_Stats::_base = NULL;
+uint8_t *GU_Stats::_heat = NULL;
+uint32_t GU_Stats::_n_pixels = 0;
+uint32_t GU_Stats::_frame_writes = 0;
+uint32_t GU_Stats::_frame_overwrites = 0;
+uint32_t GU_Stats::_total_writes = 0;
+uint32_t GU_Stats::_frames = 0;
+uint32_t GU_Stats::_kind_writes[GU_STATS_KINDS];
+GU_Stats::GU_WidgetStats GU_Stats::_widgets[GU_STATS_WIDGETS + 1];
+int GU_Stats::_n_widgets = 0;
+void *GU_Stats::_widget = NULL;
+GU_StatsKind GU_Stats::_kind = GU_STATS_OTHER;
+int GU_Stats::_entry = -1;
+
+bool GU_Stats::begin(Adafruit_GFX *gfx, bool heatmap)
+{
+  GU_FrameBuffer fb(gfx);
+
+  end();
+  if (!fb.isValid())
+    return false;
+
+  _gfx = gfx;
+  _base = fb._base;
+  _n_pixels = (uint32_t)gfx->width() * gfx->height();
+  _frame_writes = _frame_overwrites = _total_writes = _frames = 0;
+  for (int k = 0; k < GU_STATS_KINDS; k++)
+    _kind_writes[k] = 0;
+  _n_widgets = 0;
+  _entry = -1;
+
+  if (heatmap)
+  {
+    _heat = (uint8_t *)SDRAM.malloc(_n_pixels);
+    if (_heat == NULL)
+      return false;
+    memset(_heat, 0, _n_pixels);
+  }
+  return true;
+}
+
+void GU_Stats::end(void)
+{
+  if (_heat != NULL)
+    SDRAM.free(_heat);
+  _heat = NULL;
+  _gfx = NULL;
+}
+
+void GU_Stats::nextFrame(void)
+{
+  _frame_writes = 0;
+  _frame_overwrites = 0;
+  _frames++;
+  if (_heat != NULL)
+    memset(_heat, 0, _n_pixels);
+}
+
+uint8_t GU_Stats::pixelWrites(int16_t x, int16_t y)
+{
+  if (_heat == NULL || x < 0 || y < 0 || x >= _gfx->width() || y >= _gfx->height())
+    return 0;
+
+  GU_FrameBuffer fb(_gfx);
+
+  return _heat[fb.pixelAddr(x, y) - _base];
+}
+
+void GU_Stats::getWidget(int i, void **widget, GU_StatsKind *kind, uint32_t *writes)
+{
+  *widget = _widgets[i].widget;
+  *kind = _widgets[i].kind;
+  *writes = _widgets[i].writes;
+}
+
+// Count some pixel writes against the frame, the element drawing, and in
+// the heatmap.
+void GU_Stats::countPixels(uint16_t *p, int n, int step)
+{
+  _frame_writes += n;
+  _total_writes += n;
+  _kind_writes[_kind] += n;
+
+  // Find the element's entry the first time it writes anything.
+  if (_entry < 0)
+  {
+    for (_entry = 0; _entry < _n_widgets; _entry++)
+    {
+      if (_widgets[_entry].widget == _widget && _widgets[_entry].kind == _kind)
+        break;
+    }
+    if (_entry == _n_widgets && _n_widgets < GU_STATS_WIDGETS)
+    {
+      _widgets[_entry].widget = _widget;
+      _widgets[_entry].kind = _kind;
+      _widgets[_entry].writes = 0;
+      _n_widgets++;
+    }
+    else if (_entry == _n_widgets)
+    {
+      // The table is full. Use the last entry for all the rest.
+      _entry = GU_STATS_WIDGETS;
+      if (_n_widgets == GU_STATS_WIDGETS)
+      {
+        _widgets[_entry].widget = NULL;
+        _widgets[_entry].kind = GU_STATS_OTHER;
+        _widgets[_entry].writes = 0;
+        _n_widgets++;
+      }
+    }
+  }
+  _widgets[_entry].writes += n;
+
+  if (_heat != NULL)
+  {
+    uint8_t *h = _heat + (p - _base);
+
+    for (; n > 0; n--, h += step)
+    {
+      if (*h != 0)
+        _frame_overwrites++;
+      if (*h != 255)
+        (*h)++;
+    }
+  }
+}
+
+// Color of a pixel in the heatmap.
+static uint16_t heat_color(uint8_t writes)
+{
+  switch (writes)
+  {
+  case 0:
+    return 0x0000;    // black
+  case 1:
+    return 0x001F;    // blue
+  case 2:
+    return 0x07E0;    // green
+  case 3:
+    return 0xFFE0;    // yellow
+  default:
+    return writes < 8 ? 0xF800 : 0xFFFF;    // red, then white
+  }
+}
+
+// Write the heatmap in screen orientation, as dumpFrame writes the screen.
+void GU_Stats::dumpHeatmap(Print *out)
+{
+  GU_FrameBuffer fb(_gfx);
+  uint8_t chunk[64];
+  uint32_t row_bytes;
+  int16_t w, h;
+
+  if (_heat == NULL)
+    return;
+
+  w = _gfx->width();
+  h = _gfx->height();
+  row_bytes = GU_FrameBuffer::writeBMPHeader(out, w, h);
+  for (int16_t j = 0; j < h; j++)
+  {
+    uint32_t n = 0;
+
+    for (int16_t i = 0; i < w; i++)
+    {
+      uint16_t c = heat_color(_heat[fb.pixelAddr(i, j) - _base]);
+
+      chunk[n++] = c & 0xFF;
+      chunk[n++] = c >> 8;
+      if (n == sizeof(chunk))
+      {
+        out->write(chunk, n);
+        n = 0;
+      }
+    }
+    if (n > 0)
+      out->write(chunk, n);
+    if (row_bytes > w * 2u)
+    {
+      memset(chunk, 0, 2);    // pad odd widths
+      out->write(chunk, 2);
+    }
+  }
+}
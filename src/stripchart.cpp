@@ -0,0 +1,165 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+
+// Strip chart.
+
+void GU_StripChart::initChart(int16_t x1, int16_t y1, uint16_t w, uint16_t h,
+                             uint16_t background, uint16_t trace,
+                             int16_t min_value, int16_t max_value, uint16_t per_column)
+{
+  _x1 = x1;
+  _y1 = y1;
+  _w = min(w, (uint16_t)GU_STRIPCHART_COLUMNS);
+  _h = h;
+  _bgcolor = background;
+  _tracecolor = trace;
+  _min = min_value;
+  _max = max_value > min_value ? max_value : min_value + 1;
+  setSamplesPerColumn(per_column);
+  _n_columns = 0;
+  _shown = true;
+  clear();
+}
+
+void GU_StripChart::destroyChart(void)
+{
+  hideChart();
+  _n_acc = 0;
+  _n_ring = 0;
+  _n_new = 0;
+}
+
+void GU_StripChart::clear(void)
+{
+  GU_FrameBuffer fb(_gfx);
+
+  _n_acc = 0;
+  _n_ring = 0;
+  _n_new = 0;
+  GU_Frame::validate(this);
+  if (!_shown)
+    return;
+  GU_Stats::setWidget(this, GU_STATS_CHART);
+  fb.fillRect(_x1, _y1, _w, _h, _bgcolor);
+}
+
+// Fold the samples into the column being filled, and finish it every
+// _per_column samples.
+void GU_StripChart::addSamples(const int16_t *values, int n)
+{
+  int16_t lo = _acc_lo;
+  int16_t hi = _acc_hi;
+  uint16_t n_acc = _n_acc;
+  bool finished = false;
+
+  for (int i = 0; i < n; i++)
+  {
+    int16_t v = values[i];
+
+    if (n_acc == 0)
+    {
+      lo = hi = v;
+    }
+    else
+    {
+      if (v < lo)
+        lo = v;
+      if (v > hi)
+        hi = v;
+    }
+    if (++n_acc < _per_column)
+      continue;
+
+    _ring[_head].lo = lo;
+    _ring[_head].hi = hi;
+    _head = (_head + 1) % GU_STRIPCHART_COLUMNS;
+    if (_n_ring < _w)
+      _n_ring++;
+    if (_n_new < _w)
+      _n_new++;
+    _n_columns++;
+    n_acc = 0;
+    finished = true;
+  }
+  _acc_lo = lo;
+  _acc_hi = hi;
+  _n_acc = n_acc;
+
+  if (finished && _shown)
+    GU_Frame::invalidate(this, chart_redraw_wrapper);
+}
+
+int16_t GU_StripChart::valueToY(int16_t value)
+{
+  value = constrain(value, _min, _max);
+  return _y1 + _h - 1 - (int32_t)(value - _min) * (_h - 1) / (_max - _min);
+}
+
+// Draw a column at x, from the ring (age 0 is the newest). The trace reaches
+// to the column before, so a fast-moving signal still draws a joined-up line.
+void GU_StripChart::drawColumn(GU_FrameBuffer *fb, int16_t x, int age)
+{
+  GU_Envelope *c = column(age);
+  int16_t lo = c->lo;
+  int16_t hi = c->hi;
+  int16_t y1, y2;
+
+  if (age + 1 < _n_ring)
+  {
+    GU_Envelope *prev = column(age + 1);
+
+    lo = min(lo, prev->hi);
+    hi = max(hi, prev->lo);
+  }
+  y1 = valueToY(hi);
+  y2 = valueToY(lo);
+
+  fb->drawFastVLine(x, _y1, y1 - _y1, _bgcolor);
+  fb->drawFastVLine(x, y1, y2 - y1 + 1, _tracecolor);
+  fb->drawFastVLine(x, y2 + 1, _y1 + _h - 1 - y2, _bgcolor);
+}
+
+// Draw the whole chart, newest column at the right.
+void GU_StripChart::drawChart(void)
+{
+  GU_FrameBuffer fb(_gfx);
+
+  _shown = true;
+  GU_Frame::validate(this);
+  GU_Stats::setWidget(this, GU_STATS_CHART);
+  if (_n_ring < _w)
+    fb.fillRect(_x1, _y1, _w - _n_ring, _h, _bgcolor);
+  for (int age = 0; age < _n_ring; age++)
+    drawColumn(&fb, _x1 + _w - 1 - age, age);
+  _n_new = 0;
+}
+
+// Move the chart left by the number of new columns, and draw them at the
+// right. If they fill the chart (or the screen can't be moved), draw it all.
+void GU_StripChart::drawNew(void)
+{
+  GU_FrameBuffer fb(_gfx);
+  uint16_t n = _n_new;
+
+  if (n == 0)
+    return;
+  if (n >= _w || !fb.isValid())
+  {
+    drawChart();
+    return;
+  }
+
+  GU_Stats::setWidget(this, GU_STATS_CHART);
+  fb.moveRect(_x1 + n, _y1, _w - n, _h, -n, 0);
+  for (int age = n - 1; age >= 0; age--)
+    drawColumn(&fb, _x1 + _w - 1 - age, age);
+  _n_new = 0;
+}
+
+// Wrapper outside the class so it can be passed as a function pointer.
+void chart_redraw_wrapper(void *param)
+{
+  GU_StripChart *chart = (GU_StripChart *)param;
+
+  chart->drawNew();
+}
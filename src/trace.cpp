@@ -0,0 +1,217 @@
+#include "Arduino.h"
+#include "GU_Elements.h"
+
+// Gesture traces.
+//
+// A trace starts with the 4 bytes "GUT" and a version, followed by events of
+// GU_TRACE_EVENT_SIZE bytes:
+//  0     target
+//  1     event type
+//  2-3   ms since the previous event
+//  4-5   event index
+//  6-13  x, y, dx, dy
+//  14-15 element id
+// Values are held in the device's byte order.
+
+#define TRACE_VERSION 2
+
+uint8_t *GU_Trace::_buf = NULL;
+uint32_t GU_Trace::_size = 0;
+uint32_t GU_Trace::_len = 0;
+unsigned long GU_Trace::_last_ms = 0;
+bool GU_Trace::_replaying = false;
+unsigned long GU_Trace::_virtual_ms = 0;
+void *GU_Trace::_elements[GU_TRACE_ELEMENTS];
+
+// Callbacks for each target.
+static void *const targets[GU_TRACE_TARGETS] =
+{
+  (void *)menu_tap_wrapper,
+  (void *)menu_item_wrapper,
+  (void *)menu_drag_wrapper,
+  (void *)menu_cancel_wrapper,
+  (void *)pager_swipe_wrapper,
+  (void *)dotsCB,
+  (void *)cancelCB,
+  (void *)registry_tap_wrapper,
+  (void *)keyboard_tap_wrapper,
+  (void *)slider_drag_wrapper
+};
+
+static bool is_drag(uint8_t target)
+{
+  return target == GU_TRACE_MENU_DRAG || target == GU_TRACE_PAGER_SWIPE
+         || target == GU_TRACE_SLIDER;
+}
+
+// Give an element the first free id. If there isn't one, its events are
+// recorded without an element, and rejected when replayed.
+void GU_Trace::addElement(void *element)
+{
+  for (int i = 0; i < GU_TRACE_ELEMENTS; i++)
+  {
+    if (_elements[i] == NULL)
+    {
+      _elements[i] = element;
+      return;
+    }
+  }
+}
+
+void GU_Trace::removeElement(void *element)
+{
+  int id = elementId(element);
+
+  if (id != GU_TRACE_NO_ELEMENT)
+    _elements[id] = NULL;
+}
+
+int GU_Trace::elementId(void *element)
+{
+  for (int i = 0; i < GU_TRACE_ELEMENTS; i++)
+  {
+    if (_elements[i] == element && element != NULL)
+      return i;
+  }
+  return GU_TRACE_NO_ELEMENT;
+}
+
+void GU_Trace::record(uint8_t *buf, uint32_t size)
+{
+  _buf = NULL;
+  if (size < 4)
+    return;
+
+  buf[0] = 'G';
+  buf[1] = 'U';
+  buf[2] = 'T';
+  buf[3] = TRACE_VERSION;
+  _buf = buf;
+  _size = size;
+  _len = 4;
+  _last_ms = millis();
+}
+
+uint32_t GU_Trace::stop(void)
+{
+  _buf = NULL;
+  return _len;
+}
+
+void GU_Trace::add(GU_TraceTarget target, EventType ev, int indx, void *param,
+                   int x, int y, int dx, int dy)
+{
+  uint8_t *e = _buf + _len;
+  unsigned long now = millis();
+  uint16_t dt = min(now - _last_ms, 60000UL);
+  int16_t v[6] = { (int16_t)indx, (int16_t)x, (int16_t)y, (int16_t)dx, (int16_t)dy,
+                   (int16_t)elementId(param) };
+
+  if (_len + GU_TRACE_EVENT_SIZE > _size)
+  {
+    _buf = NULL;    // full
+    return;
+  }
+
+  e[0] = target;
+  e[1] = ev;
+  memcpy(e + 2, &dt, 2);
+  memcpy(e + 4, v, sizeof(v));
+  _len += GU_TRACE_EVENT_SIZE;
+  _last_ms = now;
+}
+
+// Deliver each event at its time on the virtual clock, with a frame tick
+// before it as loop() would do. Events whose target or element can't be
+// found are rejected: the time still passes, but nothing is delivered.
+bool GU_Trace::replay(const uint8_t *trace, uint32_t len, GU_TraceResult *result)
+{
+  memset(result, 0, sizeof(GU_TraceResult));
+  if (len < 4 || trace[0] != 'G' || trace[1] != 'U' || trace[2] != 'T' || trace[3] != TRACE_VERSION)
+    return false;
+
+  _replaying = true;
+  _virtual_ms = 0;
+  for (uint32_t i = 4; i + GU_TRACE_EVENT_SIZE <= len; i += GU_TRACE_EVENT_SIZE)
+  {
+    const uint8_t *e = trace + i;
+    uint16_t dt;
+    int16_t v[6];
+    uint16_t id;
+    void *param;
+    unsigned long start;
+    uint32_t us;
+
+    memcpy(&dt, e + 2, 2);
+    memcpy(v, e + 4, sizeof(v));
+    _virtual_ms += dt;
+    id = (uint16_t)v[5];
+    param = id < GU_TRACE_ELEMENTS ? _elements[id] : NULL;
+    if (e[0] >= GU_TRACE_TARGETS || param == NULL)
+    {
+      result->rejected++;
+      continue;
+    }
+
+    start = micros();
+    if (GU_Frame::tick())
+      result->frames++;
+    if (is_drag(e[0]))
+      ((DragCB)targets[e[0]])((EventType)e[1], v[0], param, v[1], v[2], v[3], v[4]);
+    else
+      ((TapCB)targets[e[0]])((EventType)e[1], v[0], param, v[1], v[2]);
+    us = micros() - start;
+
+    result->events++;
+    result->frames++;
+    result->draw_us += us;
+    result->max_us = max(result->max_us, us);
+  }
+
+  // Let animations the last events started run out, a frame at a time.
+  while (GU_Frame::numAnimating() > 0)
+  {
+    unsigned long start = micros();
+
+    _virtual_ms++;
+    if (GU_Frame::tick())
+    {
+      uint32_t us = micros() - start;
+
+      result->frames++;
+      result->draw_us += us;
+      result->max_us = max(result->max_us, us);
+    }
+  }
+
+  // Draw anything the last events left waiting.
+  if (GU_Frame::numDirty() > 0)
+  {
+    unsigned long start = micros();
+
+    GU_Frame::flush();
+    result->frames++;
+    result->draw_us += micros() - start;
+  }
+  result->trace_ms = _virtual_ms;
+  _replaying = false;
+  return true;
+}
+
+void GU_Trace::dump(Print *out, const uint8_t *trace, uint32_t len)
+{
+  const char *hex = "0123456789ABCDEF";
+
+  out->println("const uint8_t trace[] = {");
+  for (uint32_t i = 0; i < len; i++)
+  {
+    char b[7] = { '0', 'x', hex[trace[i] >> 4], hex[trace[i] & 15], ',', ' ', 0 };
+
+    if (i % 16 == 0)
+      out->print("  ");
+    out->print(b);
+    if (i % 16 == 15 || i == len - 1)
+      out->println("");
+  }
+  out->println("};");
+}
@@ -0,0 +1,185 @@
+#include <chrono>
+#include "test.h"
+
+// Pixel writes and draw times of the common drawing paths, on the host,
+// then the throughput of the RGB565 span functions over a screenful.
+// Run it before and after a change to see what the change did. The times
+// are the host's, so only compare them with other runs on the same machine;
+// the pixel writes are the same as on the board.
+//
+//   gu_bench [repeats]
+
+GestureDetector detector;
+GigaDisplay_GFX tft;
+FontCollection fc(&tft, NULL, NULL, 1, 1);
+
+GU_Button button(&fc, &detector);
+GU_Menu menu(&fc, &detector);
+GU_Pager pager(&tft, &detector);
+
+typedef std::chrono::steady_clock Clock;
+
+// Time and count the writes of the part of each repeat done by what, after
+// setup (which isn't counted).
+void bench(const char *name, int repeats, void (*setup)(void), void (*what)(void))
+{
+  Clock::duration taken = Clock::duration::zero();
+  uint32_t writes = 0;
+
+  for (int i = 0; i < repeats; i++)
+  {
+    Clock::time_point start;
+
+    if (setup != NULL)
+      (*setup)();
+    GU_Stats::begin(&tft, false);
+    start = Clock::now();
+    (*what)();
+    taken += Clock::now() - start;
+    writes += GU_Stats::totalWrites();
+    GU_Stats::end();
+  }
+  printf("%-20s %10u %10.1f\n", name, writes / repeats,
+         std::chrono::duration<double, std::micro>(taken).count() / repeats);
+}
+
+// A screenful to run the span functions over, and a second one to take
+// pixels from. One pixel in, so that the odd-address paths are timed too.
+#define N_PIXELS (800 * 480)
+
+uint16_t span_dst[N_PIXELS + 1];
+uint16_t span_src[N_PIXELS + 1];
+
+// Time what over the screenful, and print how many millions of pixels a
+// second it does.
+void kernel(const char *name, int repeats, void (*what)(uint16_t *dst, const uint16_t *src, int n))
+{
+  Clock::time_point start = Clock::now();
+  double seconds;
+
+  for (int i = 0; i < repeats; i++)
+    (*what)(span_dst, span_src, N_PIXELS);
+  seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  printf("%-20s %10.1f\n", name, (double)N_PIXELS * repeats / seconds / 1e6);
+}
+
+// The average as it was done a pixel at a time, unpacking each field.
+void unpack_average(uint16_t *dst, const uint16_t *src, int n)
+{
+  for (int i = 0; i < n; i++)
+  {
+    uint8_t r1, g1, b1, r2, g2, b2;
+
+    rgb565_unpack(dst[i], &r1, &g1, &b1);
+    rgb565_unpack(src[i], &r2, &g2, &b2);
+    dst[i] = rgb565_pack((r1 + r2) / 2, (g1 + g2) / 2, (b1 + b2) / 2);
+  }
+}
+
+void average_span(uint16_t *dst, const uint16_t *src, int n)
+{
+  rgb565_average_span(dst, src, n);
+}
+
+void average_odd(uint16_t *dst, const uint16_t *src, int n)
+{
+  rgb565_average_span(dst + 1, src, n);
+}
+
+void blend_span(uint16_t *dst, const uint16_t *src, int n)
+{
+  rgb565_blend_span(dst, src, n, 12);
+}
+
+void mix_span(uint16_t *dst, const uint16_t *src, int n)
+{
+  rgb565_mix_span(dst, n, BLUE, 12);
+}
+
+void darken_span(uint16_t *dst, const uint16_t *src, int n)
+{
+  rgb565_darken_span(dst, n, 12);
+}
+
+void halve_span(uint16_t *dst, const uint16_t *src, int n)
+{
+  rgb565_darken_span(dst, n, RGB565_ALPHA_MAX / 2);
+}
+
+void menu_cb(EventType ev, int indx, void *param, int x, int y)
+{
+}
+
+void swipe_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
+{
+}
+
+void draw_button(void)
+{
+  button.drawButton();
+}
+
+void set_text(void)
+{
+  static int n = 0;
+
+  button.setText(n++ & 1 ? (char *)"Menu" : (char *)"Other");
+}
+
+void open_menu(void)
+{
+  detector.tap(300, 20);
+}
+
+void close_menu(void)
+{
+  if (menu.isAnyMenuDisplayed())
+    detector.tap(700, 400);
+}
+
+void clear_page(void)
+{
+  pager.clearPage(true);
+}
+
+int main(int argc, char **argv)
+{
+  int repeats = argc > 1 ? atoi(argv[1]) : 1000;
+
+  tft.begin();
+  tft.setRotation(1);
+  detector.setRotation(1);
+  repeats = max(repeats, 1);
+
+  pager.initPager(3, 0, swipe_cb, NULL, BLACK);
+  button.initButtonUL(240, 5, 150, 45, WHITE, DKGREY, WHITE, "Menu", 1);
+  menu.initMenu(&button, WHITE, DKGREY, GREY, WHITE, menu_cb, 3);
+  menu.beginMenuItems();
+  for (int i = 0; i < 10; i++)
+    menu.setMenuItem(i, "A menu item", i != 3, i == 5);
+  menu.commitMenuItems();
+
+  printf("%-20s %10s %10s\n", "", "pixels", "us");
+  bench("drawButton", repeats, NULL, draw_button);
+  bench("setText", repeats, NULL, set_text);
+  bench("menu drop down", repeats, close_menu, open_menu);
+  bench("menu take down", repeats, open_menu, close_menu);
+  menu.setSaveUnder(true);
+  bench("  with save-under", repeats, open_menu, close_menu);
+  bench("clearPage", repeats, NULL, clear_page);
+
+  for (int i = 0; i <= N_PIXELS; i++)
+  {
+    span_dst[i] = i * 7919;
+    span_src[i] = i * 104729;
+  }
+  printf("\n%-20s %10s\n", "", "Mpixels/s");
+  kernel("unpack average", repeats, unpack_average);
+  kernel("average_span", repeats, average_span);
+  kernel("  one odd", repeats, average_odd);
+  kernel("blend_span", repeats, blend_span);
+  kernel("mix_span", repeats, mix_span);
+  kernel("darken_span", repeats, darken_span);
+  kernel("  by half", repeats, halve_span);
+  return 0;
+}
@@ -0,0 +1,324 @@
+#include "Adafruit_GFX.h"
+
+// The shapes are drawn by the same steps as in Adafruit_GFX, so the same
+// pixels come out.
+
+#define swap_int16(a, b) { int16_t t = a; a = b; b = t; }
+
+void Adafruit_GFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color)
+{
+  startWrite();
+  for (int16_t i = 0; i < h; i++)
+    writePixel(x, y + i, color);
+  endWrite();
+}
+
+void Adafruit_GFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color)
+{
+  startWrite();
+  for (int16_t i = 0; i < w; i++)
+    writePixel(x + i, y, color);
+  endWrite();
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  for (int16_t i = x; i < x + w; i++)
+    drawFastVLine(i, y, h, color);
+}
+
+void Adafruit_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color)
+{
+  int16_t steep = abs(y1 - y0) > abs(x1 - x0);
+  int16_t dx, dy, err, ystep;
+
+  if (steep)
+  {
+    swap_int16(x0, y0);
+    swap_int16(x1, y1);
+  }
+  if (x0 > x1)
+  {
+    swap_int16(x0, x1);
+    swap_int16(y0, y1);
+  }
+  dx = x1 - x0;
+  dy = abs(y1 - y0);
+  err = dx / 2;
+  ystep = y0 < y1 ? 1 : -1;
+
+  startWrite();
+  for (; x0 <= x1; x0++)
+  {
+    if (steep)
+      writePixel(y0, x0, color);
+    else
+      writePixel(x0, y0, color);
+    err -= dy;
+    if (err < 0)
+    {
+      y0 += ystep;
+      err += dx;
+    }
+  }
+  endWrite();
+}
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
+{
+  startWrite();
+  drawFastHLine(x, y, w, color);
+  drawFastHLine(x, y + h - 1, w, color);
+  drawFastVLine(x, y, h, color);
+  drawFastVLine(x + w - 1, y, h, color);
+  endWrite();
+}
+
+void Adafruit_GFX::drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+  int16_t f = 1 - r;
+  int16_t ddF_x = 1;
+  int16_t ddF_y = -2 * r;
+  int16_t x = 0;
+  int16_t y = r;
+
+  startWrite();
+  writePixel(x0, y0 + r, color);
+  writePixel(x0, y0 - r, color);
+  writePixel(x0 + r, y0, color);
+  writePixel(x0 - r, y0, color);
+  while (x < y)
+  {
+    if (f >= 0)
+    {
+      y--;
+      ddF_y += 2;
+      f += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f += ddF_x;
+    writePixel(x0 + x, y0 + y, color);
+    writePixel(x0 - x, y0 + y, color);
+    writePixel(x0 + x, y0 - y, color);
+    writePixel(x0 - x, y0 - y, color);
+    writePixel(x0 + y, y0 + x, color);
+    writePixel(x0 - y, y0 + x, color);
+    writePixel(x0 + y, y0 - x, color);
+    writePixel(x0 - y, y0 - x, color);
+  }
+  endWrite();
+}
+
+void Adafruit_GFX::drawCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername, uint16_t color)
+{
+  int16_t f = 1 - r;
+  int16_t ddF_x = 1;
+  int16_t ddF_y = -2 * r;
+  int16_t x = 0;
+  int16_t y = r;
+
+  while (x < y)
+  {
+    if (f >= 0)
+    {
+      y--;
+      ddF_y += 2;
+      f += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f += ddF_x;
+    if (cornername & 0x4)
+    {
+      writePixel(x0 + x, y0 + y, color);
+      writePixel(x0 + y, y0 + x, color);
+    }
+    if (cornername & 0x2)
+    {
+      writePixel(x0 + x, y0 - y, color);
+      writePixel(x0 + y, y0 - x, color);
+    }
+    if (cornername & 0x8)
+    {
+      writePixel(x0 - y, y0 + x, color);
+      writePixel(x0 - x, y0 + y, color);
+    }
+    if (cornername & 0x1)
+    {
+      writePixel(x0 - y, y0 - x, color);
+      writePixel(x0 - x, y0 - y, color);
+    }
+  }
+}
+
+void Adafruit_GFX::fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color)
+{
+  startWrite();
+  drawFastVLine(x0, y0 - r, 2 * r + 1, color);
+  fillCircleHelper(x0, y0, r, 3, 0, color);
+  endWrite();
+}
+
+void Adafruit_GFX::fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint16_t color)
+{
+  int16_t f = 1 - r;
+  int16_t ddF_x = 1;
+  int16_t ddF_y = -2 * r;
+  int16_t x = 0;
+  int16_t y = r;
+  int16_t px = x;
+  int16_t py = y;
+
+  delta++;    // avoid some +1's in the loop
+  while (x < y)
+  {
+    if (f >= 0)
+    {
+      y--;
+      ddF_y += 2;
+      f += ddF_y;
+    }
+    x++;
+    ddF_x += 2;
+    f += ddF_x;
+    // These checks avoid double-drawing certain lines
+    if (x < (y + 1))
+    {
+      if (corners & 1)
+        drawFastVLine(x0 + x, y0 - y, 2 * y + delta, color);
+      if (corners & 2)
+        drawFastVLine(x0 - x, y0 - y, 2 * y + delta, color);
+    }
+    if (y != py)
+    {
+      if (corners & 1)
+        drawFastVLine(x0 + py, y0 - px, 2 * px + delta, color);
+      if (corners & 2)
+        drawFastVLine(x0 - py, y0 - px, 2 * px + delta, color);
+      py = y;
+    }
+    px = x;
+  }
+}
+
+void Adafruit_GFX::drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color)
+{
+  int16_t max_radius = ((w < h) ? w : h) / 2;
+
+  if (r > max_radius)
+    r = max_radius;
+  startWrite();
+  drawFastHLine(x + r, y, w - 2 * r, color);
+  drawFastHLine(x + r, y + h - 1, w - 2 * r, color);
+  drawFastVLine(x, y + r, h - 2 * r, color);
+  drawFastVLine(x + w - 1, y + r, h - 2 * r, color);
+  drawCircleHelper(x + r, y + r, r, 1, color);
+  drawCircleHelper(x + w - r - 1, y + r, r, 2, color);
+  drawCircleHelper(x + w - r - 1, y + h - r - 1, r, 4, color);
+  drawCircleHelper(x + r, y + h - r - 1, r, 8, color);
+  endWrite();
+}
+
+void Adafruit_GFX::fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color)
+{
+  int16_t max_radius = ((w < h) ? w : h) / 2;
+
+  if (r > max_radius)
+    r = max_radius;
+  startWrite();
+  fillRect(x + r, y, w - 2 * r, h, color);
+  fillCircleHelper(x + w - r - 1, y + r, r, 1, h - 2 * r - 1, color);
+  fillCircleHelper(x + r, y + r, r, 2, h - 2 * r - 1, color);
+  endWrite();
+}
+
+void Adafruit_GFX::drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h)
+{
+  startWrite();
+  for (int16_t j = 0; j < h; j++)
+  {
+    for (int16_t i = 0; i < w; i++)
+      writePixel(x + i, y + j, bitmap[j * w + i]);
+  }
+  endWrite();
+}
+
+void Adafruit_GFX::setRotation(uint8_t r)
+{
+  rotation = r & 3;
+  if (rotation & 1)
+  {
+    _width = HEIGHT;
+    _height = WIDTH;
+  }
+  else
+  {
+    _width = WIDTH;
+    _height = HEIGHT;
+  }
+}
+
+// ---------------------------------------------------------------------------------
+
+GFXcanvas1::GFXcanvas1(uint16_t w, uint16_t h, bool allocate_buffer) : Adafruit_GFX(w, h)
+{
+  buffer = allocate_buffer ? (uint8_t *)calloc((w + 7) / 8 * h, 1) : NULL;
+  buffer_owned = allocate_buffer;
+}
+
+GFXcanvas1::~GFXcanvas1()
+{
+  if (buffer_owned)
+    free(buffer);
+}
+
+void GFXcanvas1::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+  uint8_t *ptr;
+
+  if (buffer == NULL || x < 0 || y < 0 || x >= _width || y >= _height)
+    return;
+  HOST_ROTATE(x, y);
+  ptr = &buffer[(x / 8) + y * ((WIDTH + 7) / 8)];
+  if (color)
+    *ptr |= 0x80 >> (x & 7);
+  else
+    *ptr &= ~(0x80 >> (x & 7));
+}
+
+bool GFXcanvas1::getPixel(int16_t x, int16_t y) const
+{
+  if (buffer == NULL || x < 0 || y < 0 || x >= _width || y >= _height)
+    return false;
+  HOST_ROTATE(x, y);
+  return buffer[(x / 8) + y * ((WIDTH + 7) / 8)] & (0x80 >> (x & 7));
+}
+
+GFXcanvas16::GFXcanvas16(uint16_t w, uint16_t h, bool allocate_buffer) : Adafruit_GFX(w, h)
+{
+  buffer = allocate_buffer ? (uint16_t *)calloc(w * h, sizeof(uint16_t)) : NULL;
+  buffer_owned = allocate_buffer;
+}
+
+GFXcanvas16::~GFXcanvas16()
+{
+  if (buffer_owned)
+    free(buffer);
+}
+
+void GFXcanvas16::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+  if (buffer == NULL || x < 0 || y < 0 || x >= _width || y >= _height)
+    return;
+  HOST_ROTATE(x, y);
+  buffer[x + y * WIDTH] = color;
+}
+
+uint16_t GFXcanvas16::getPixel(int16_t x, int16_t y) const
+{
+  if (buffer == NULL || x < 0 || y < 0 || x >= _width || y >= _height)
+    return 0;
+  HOST_ROTATE(x, y);
+  return buffer[x + y * WIDTH];
+}
@@ -0,0 +1,99 @@
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+// Stand-in for Adafruit_GFX, for building GU_Elements on a host. The
+// drawing primitives the library uses are drawn as Adafruit_GFX draws them,
+// so frames drawn on a host match those drawn on the board.
+
+#include "Arduino.h"
+
+// Fonts are not drawn from here (see FontCollection), but sketches name them.
+typedef struct
+{
+  uint8_t *bitmap;
+  void *glyph;
+  uint16_t first, last;
+  uint8_t yAdvance;
+} GFXfont;
+
+class Adafruit_GFX
+{
+public:
+  Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h) { _width = w; _height = h; }
+  virtual ~Adafruit_GFX() {  }
+
+  virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+  virtual void startWrite(void) {  }
+  virtual void writePixel(int16_t x, int16_t y, uint16_t color) { drawPixel(x, y, color); }
+  virtual void endWrite(void) {  }
+
+  virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  virtual void fillScreen(uint16_t color) { fillRect(0, 0, _width, _height, color); }
+  virtual void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+  virtual void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+  void drawCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+  void drawCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t cornername, uint16_t color);
+  void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+  void fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint16_t color);
+  void drawRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+  void fillRoundRect(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color);
+  void drawRGBBitmap(int16_t x, int16_t y, uint16_t *bitmap, int16_t w, int16_t h);
+
+  virtual void setRotation(uint8_t r);
+  uint8_t getRotation(void) const { return rotation; }
+  int16_t width(void) const { return _width; }
+  int16_t height(void) const { return _height; }
+  void setTextWrap(bool w) { wrap = w; }
+
+protected:
+  const int16_t WIDTH, HEIGHT;    // unrotated size
+  int16_t _width, _height;        // size as rotated
+  uint8_t rotation = 0;
+  bool wrap = true;
+};
+
+// The rotations of x/y onto a buffer of WIDTH x HEIGHT pixels, as the
+// canvases (and GigaDisplay_GFX) do them.
+#define HOST_ROTATE(x, y) \
+  do { int16_t t; \
+    switch (rotation) { \
+    case 1: t = x; x = WIDTH - 1 - y; y = t; break; \
+    case 2: x = WIDTH - 1 - x; y = HEIGHT - 1 - y; break; \
+    case 3: t = x; x = y; y = HEIGHT - 1 - t; break; \
+    } } while (0)
+
+class GFXcanvas1 : public Adafruit_GFX
+{
+public:
+  GFXcanvas1(uint16_t w, uint16_t h, bool allocate_buffer = true);
+  ~GFXcanvas1();
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  bool getPixel(int16_t x, int16_t y) const;
+  uint8_t *getBuffer(void) const { return buffer; }
+
+protected:
+  uint8_t *buffer;
+  bool buffer_owned;
+};
+
+class GFXcanvas16 : public Adafruit_GFX
+{
+public:
+  GFXcanvas16(uint16_t w, uint16_t h, bool allocate_buffer = true);
+  ~GFXcanvas16();
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color);
+  uint16_t getPixel(int16_t x, int16_t y) const;
+  uint16_t *getBuffer(void) const { return buffer; }
+
+protected:
+  uint16_t *buffer;
+  bool buffer_owned;
+};
+
+#endif
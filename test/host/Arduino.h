@@ -0,0 +1,87 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Stand-in for the Arduino core, for building GU_Elements on a host.
+// Only what the library and its tests use is here.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+
+// As in ArduinoCore-API, min and max are templates in C++.
+template <class T, class L>
+auto min(const T &a, const L &b) -> decltype((b < a) ? b : a)
+{
+  return (b < a) ? b : a;
+}
+
+template <class T, class L>
+auto max(const T &a, const L &b) -> decltype((b < a) ? b : a)
+{
+  return (a < b) ? b : a;
+}
+
+// The clock is virtual: it starts at 0 and only moves on with delay(),
+// delayMicroseconds() or hostAdvance(), so runs are repeatable.
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void hostAdvance(unsigned long us);
+
+// Host only. If set, called by delay() before the clock moves on, so a test
+// can look at the screen while an element waits (e.g. between the frames of
+// an animation).
+extern void (*hostOnDelay)(unsigned long ms);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+
+  size_t print(const char *str) { return write((const uint8_t *)str, strlen(str)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int n) { return print((long)n); }
+  size_t print(unsigned int n) { return print((unsigned long)n); }
+  size_t print(long n);
+  size_t print(unsigned long n);
+  size_t print(double n, int digits = 2);
+
+  size_t println(void) { return print("\r\n"); }
+  template <class T> size_t println(T value) { size_t n = print(value); return n + println(); }
+  size_t println(double value, int digits) { size_t n = print(value, digits); return n + println(); }
+};
+
+class Stream : public Print
+{
+};
+
+// Serial writes to stdout.
+class HardwareSerial : public Stream
+{
+public:
+  void begin(unsigned long baud) {  }
+  operator bool() { return true; }
+  size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif
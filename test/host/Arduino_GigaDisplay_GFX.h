@@ -0,0 +1,44 @@
+#ifndef HOST_ARDUINO_GIGADISPLAY_GFX_H
+#define HOST_ARDUINO_GIGADISPLAY_GFX_H
+
+// Stand-in for the Giga Display's GFX: a plain RGB565 buffer of 480 x 800
+// pixels, held in the panel's native (portrait) orientation and rotated
+// as the real one is. As on the board, there is no buffer until begin().
+
+#include "Adafruit_GFX.h"
+
+class GigaDisplay_GFX : public Adafruit_GFX
+{
+public:
+  GigaDisplay_GFX() : Adafruit_GFX(480, 800) {  }
+  ~GigaDisplay_GFX() { free(buffer); }
+
+  void begin(void)
+  {
+    if (buffer == NULL)
+      buffer = (uint16_t *)calloc(WIDTH * HEIGHT, sizeof(uint16_t));
+  }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color)
+  {
+    if (buffer == NULL || x < 0 || y < 0 || x >= _width || y >= _height)
+      return;
+    HOST_ROTATE(x, y);
+    buffer[x + y * WIDTH] = color;
+  }
+
+  uint16_t getPixel(int16_t x, int16_t y) const
+  {
+    if (buffer == NULL || x < 0 || y < 0 || x >= _width || y >= _height)
+      return 0;
+    HOST_ROTATE(x, y);
+    return buffer[x + y * WIDTH];
+  }
+
+  uint16_t *getBuffer(void) const { return buffer; }
+
+protected:
+  uint16_t *buffer = NULL;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "FontCollection.h"
+
+// Glyphs are 5 x 7 cells of 2 x 2 pixels (at text size 1). Whether a cell
+// is set comes from the character and the cell.
+static bool cell(unsigned char c, int row, int col)
+{
+  unsigned int h = c * 2654435761u + row * 40503u + col * 2246822519u;
+
+  return ((h >> 13) & 3) == 0 || row == 6;
+}
+
+void FontCollection::getTextBounds(char *str, int16_t x, int16_t y,
+                                   int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h, uint8_t textsize)
+{
+  int n = strlen(str);
+
+  *x1 = x;
+  *y1 = n > 0 ? y - HOST_FONT_ASCENT * textsize : y;
+  *w = n * HOST_FONT_ADVANCE * textsize;
+  *h = n > 0 ? HOST_FONT_HEIGHT * textsize : 0;
+}
+
+void FontCollection::drawText(char *str, int16_t x, int16_t y, uint16_t color, uint8_t textsize)
+{
+  _gfx->startWrite();
+  for (int i = 0; str[i] != '\0'; i++)
+  {
+    int16_t gx = x + i * HOST_FONT_ADVANCE * textsize;
+    int16_t gy = y - HOST_FONT_ASCENT * textsize;
+
+    if (str[i] == ' ')
+      continue;
+    for (int row = 0; row < 7; row++)
+    {
+      for (int col = 0; col < 5; col++)
+      {
+        if (cell(str[i], row, col))
+          _gfx->fillRect(gx + col * 2 * textsize, gy + row * 2 * textsize, 2 * textsize, 2 * textsize, color);
+      }
+    }
+  }
+  _gfx->endWrite();
+}
@@ -0,0 +1,30 @@
+#ifndef HOST_FONTCOLLECTION_H
+#define HOST_FONTCOLLECTION_H
+
+// Stand-in for FontCollection. The fonts passed in are not used: every
+// character is drawn from the same made-up font, HOST_FONT_ADVANCE pixels
+// apart, with a pattern of dots that depends on the character. So text
+// has the size and placement of real text, and frames are repeatable.
+
+#include "Adafruit_GFX.h"
+
+#define HOST_FONT_ADVANCE   12      // pixels from one character to the next
+#define HOST_FONT_ASCENT    12      // pixels above the baseline
+#define HOST_FONT_HEIGHT    16      // pixels from the top to the bottom of the descenders
+
+class FontCollection
+{
+public:
+  FontCollection(Adafruit_GFX *gfx, const GFXfont *font, const GFXfont *symfont,
+                 uint8_t size_x, uint8_t size_y) { _gfx = gfx; }
+
+  void getTextBounds(char *str, int16_t x, int16_t y,
+                     int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h, uint8_t textsize = 1);
+  void drawText(char *str, int16_t x, int16_t y, uint16_t color, uint8_t textsize = 1);
+  void drawText(char ch, int16_t x, int16_t y, uint16_t color, uint8_t textsize = 1)
+       { char text[2] = {ch, 0}; drawText(text, x, y, color, textsize); }
+
+  Adafruit_GFX *_gfx;
+};
+
+#endif
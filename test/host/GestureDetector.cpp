@@ -0,0 +1,104 @@
+#include "GestureDetector.h"
+
+bool GestureDetector::onTap(int x, int y, int w, int h, TapCB callback, int indx, void *param)
+{
+  if (indx < 0 || indx >= MAX_EVENTS)
+    return false;
+  _events[indx] = { EV_TAP, x, y, w, h, callback, NULL, param, CO_NONE };
+  return true;
+}
+
+bool GestureDetector::onDrag(int x, int y, int w, int h, DragCB callback, int indx, void *param)
+{
+  if (indx < 0 || indx >= MAX_EVENTS)
+    return false;
+  _events[indx] = { EV_DRAG, x, y, w, h, NULL, callback, param, CO_NONE };
+  return true;
+}
+
+bool GestureDetector::onSwipe(int x, int y, int w, int h, DragCB callback, int indx, void *param,
+                              Constraint constraint, int min_speed)
+{
+  if (indx < 0 || indx >= MAX_EVENTS)
+    return false;
+  _events[indx] = { EV_SWIPE, x, y, w, h, NULL, callback, param, constraint };
+  return true;
+}
+
+void GestureDetector::cancelEvent(int indx)
+{
+  if (indx >= 0 && indx < MAX_EVENTS)
+    _events[indx].type = EV_NONE;
+}
+
+bool GestureDetector::isEventRegistered(int indx)
+{
+  return indx >= 0 && indx < MAX_EVENTS && _events[indx].type != EV_NONE;
+}
+
+// The highest event of a type whose area holds x/y, or -1.
+int GestureDetector::find(EventType type, int x, int y)
+{
+  for (int i = MAX_EVENTS - 1; i >= 0; i--)
+  {
+    Event *e = &_events[i];
+
+    if (e->type != type)
+      continue;
+    if (e->w == 0 || e->h == 0)
+      return i;
+    if (x >= e->x && x < e->x + e->w && y >= e->y && y < e->y + e->h)
+      return i;
+  }
+  return -1;
+}
+
+// The press may change the events (a menu registers its items), so the
+// release goes to the callback that had the press.
+bool GestureDetector::tap(int x, int y, bool long_press, unsigned long ms)
+{
+  int i = find(EV_TAP, x, y);
+  Event e;
+
+  if (i < 0)
+    return false;
+  e = _events[i];
+  (*e.tap)(EV_TAP, i, e.param, x, y);
+  delay(ms);
+  (*e.tap)((EventType)(EV_TAP | EV_RELEASED | (long_press ? EV_LONG_PRESS : 0)), i, e.param, x, y);
+  return true;
+}
+
+bool GestureDetector::drag(int x, int y, int dx, int dy, int steps, unsigned long step_ms)
+{
+  int i = find(EV_DRAG, x, y);
+  Event e;
+
+  if (i < 0)
+    return false;
+  e = _events[i];
+  steps = max(steps, 1);
+  for (int s = 1; s <= steps; s++)
+  {
+    delay(step_ms);
+    (*e.drag)(EV_DRAG, i, e.param, x, y, dx * s / steps, dy * s / steps);
+  }
+  (*e.drag)((EventType)(EV_DRAG | EV_RELEASED), i, e.param, x, y, dx, dy);
+  return true;
+}
+
+bool GestureDetector::swipe(int x, int y, int dx, int dy)
+{
+  int i = find(EV_SWIPE, x, y);
+  Event e;
+
+  if (i < 0)
+    return false;
+  e = _events[i];
+  if (e.constraint == CO_HORIZ)
+    dy = 0;
+  else if (e.constraint == CO_VERT)
+    dx = 0;
+  (*e.drag)(EV_SWIPE, i, e.param, x, y, dx, dy);
+  return true;
+}
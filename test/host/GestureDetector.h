@@ -0,0 +1,75 @@
+#ifndef HOST_GESTUREDETECTOR_H
+#define HOST_GESTUREDETECTOR_H
+
+// Stand-in for GestureDetector. Events are registered as on the board, but
+// there is no touch screen: tests deliver taps, drags and swipes with
+// tap(), drag() and swipe(). Each goes to the registered event of highest
+// index whose area holds it (an area of zero size holds the whole screen),
+// as poll() would deliver a touch.
+
+#include "Arduino.h"
+
+#define MAX_EVENTS  20
+
+typedef enum
+{
+  EV_NONE = 0,
+  EV_TAP = 1,
+  EV_DRAG = 2,
+  EV_SWIPE = 4,
+  EV_LONG_PRESS = 8,
+  EV_RELEASED = 0x80
+} EventType;
+
+typedef enum
+{
+  CO_NONE,
+  CO_HORIZ,
+  CO_VERT
+} Constraint;
+
+typedef void (*TapCB)(EventType ev, int indx, void *param, int x, int y);
+typedef void (*DragCB)(EventType ev, int indx, void *param, int x, int y, int dx, int dy);
+
+class GestureDetector
+{
+public:
+  bool begin(void) { return true; }
+  void poll(void) {  }
+  void setRotation(int rotation) {  }
+
+  bool onTap(int x, int y, int w, int h, TapCB callback, int indx, void *param);
+  bool onDrag(int x, int y, int w, int h, DragCB callback, int indx, void *param);
+  bool onSwipe(int x, int y, int w, int h, DragCB callback, int indx, void *param,
+               Constraint constraint = CO_NONE, int min_speed = 0);
+  void cancelEvent(int indx);
+  bool isEventRegistered(int indx);
+
+  // Host only. Deliver a press and release at x/y, taking ms between them.
+  // Return false if no tap event took it.
+  bool tap(int x, int y, bool long_press = false, unsigned long ms = 50);
+
+  // Host only. Drag from x/y by dx/dy, in steps moves of step_ms each, then
+  // release. Return false if no drag event took it.
+  bool drag(int x, int y, int dx, int dy, int steps = 4, unsigned long step_ms = 20);
+
+  // Host only. Swipe from x/y by dx/dy. Return false if no swipe event took it.
+  bool swipe(int x, int y, int dx, int dy);
+
+private:
+  typedef struct Event
+  {
+    EventType type;
+    int x, y, w, h;
+    TapCB tap;
+    DragCB drag;
+    void *param;
+    Constraint constraint;
+  } Event;
+
+  Event _events[MAX_EVENTS] = {};
+
+  int find(EventType type, int x, int y);
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef HOST_SDRAM_H
+#define HOST_SDRAM_H
+
+// Stand-in for the Giga's SDRAM allocator: on a host it is just the heap.
+
+#include "Arduino.h"
+
+class SDRAMClass
+{
+public:
+  int begin(uint32_t start_address = 0) { return 1; }
+  void *malloc(size_t size) { return ::malloc(size); }
+  void free(void *ptr) { ::free(ptr); }
+};
+
+extern SDRAMClass SDRAM;
+
+#endif
@@ -0,0 +1,88 @@
+#include "Arduino.h"
+#include "SDRAM.h"
+
+// The parts of the Arduino core that aren't inline.
+
+HardwareSerial Serial;
+SDRAMClass SDRAM;
+
+static unsigned long long clock_us = 0;
+void (*hostOnDelay)(unsigned long ms) = NULL;
+
+unsigned long millis(void)
+{
+  return clock_us / 1000;
+}
+
+unsigned long micros(void)
+{
+  return clock_us;
+}
+
+void delay(unsigned long ms)
+{
+  if (hostOnDelay != NULL)
+    (*hostOnDelay)(ms);
+  clock_us += ms * 1000ULL;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  clock_us += us;
+}
+
+void hostAdvance(unsigned long us)
+{
+  clock_us += us;
+}
+
+// The same sequence on every run.
+static uint32_t seed = 1;
+
+long random(long howbig)
+{
+  if (howbig <= 0)
+    return 0;
+  seed = seed * 1103515245 + 12345;
+  return (seed >> 8) % howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+  if (howsmall >= howbig)
+    return howsmall;
+  return howsmall + random(howbig - howsmall);
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+
+  while (size-- > 0)
+    n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(long n)
+{
+  char buf[24];
+
+  snprintf(buf, sizeof(buf), "%ld", n);
+  return print(buf);
+}
+
+size_t Print::print(unsigned long n)
+{
+  char buf[24];
+
+  snprintf(buf, sizeof(buf), "%lu", n);
+  return print(buf);
+}
+
+size_t Print::print(double n, int digits)
+{
+  char buf[40];
+
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return print(buf);
+}
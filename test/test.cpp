@@ -0,0 +1,144 @@
+#include "test.h"
+
+int test_failures = 0;
+
+int testResult(void)
+{
+  if (test_failures > 0)
+  {
+    fprintf(stderr, "%d checks failed\n", test_failures);
+    return 1;
+  }
+  return 0;
+}
+
+bool writeFile(const char *path, const std::vector<uint8_t> &bytes)
+{
+  FILE *f = fopen(path, "wb");
+  bool ok;
+
+  if (f == NULL)
+    return false;
+  ok = fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+  return fclose(f) == 0 && ok;
+}
+
+static bool readFile(const char *path, std::vector<uint8_t> *bytes)
+{
+  FILE *f = fopen(path, "rb");
+  uint8_t buf[4096];
+  size_t n;
+
+  if (f == NULL)
+    return false;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    bytes->insert(bytes->end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+static void put16(std::vector<uint8_t> *out, uint32_t v)
+{
+  out->push_back(v & 0xFF);
+  out->push_back((v >> 8) & 0xFF);
+}
+
+static void put32(std::vector<uint8_t> *out, uint32_t v)
+{
+  put16(out, v & 0xFFFF);
+  put16(out, v >> 16);
+}
+
+// Write a rectangle of the screen as a top-down RGB565 BMP, as
+// GU_FrameBuffer::dumpFrame does. It's done here, through getPixel, so the
+// golden images can be made by older versions of the library too.
+static void frameBMP(GigaDisplay_GFX *gfx, int16_t x, int16_t y, uint16_t w, uint16_t h,
+                     std::vector<uint8_t> *out)
+{
+  uint32_t row_bytes = (w * 2 + 3) & ~3;
+
+  out->push_back('B');
+  out->push_back('M');
+  put32(out, 66 + row_bytes * h);   // file size
+  put32(out, 0);
+  put32(out, 66);                   // offset to pixels
+  put32(out, 40);                   // BITMAPINFOHEADER
+  put32(out, w);
+  put32(out, -(int32_t)h);          // negative height = top-down
+  put16(out, 1);                    // planes
+  put16(out, 16);                   // bits per pixel
+  put32(out, 3);                    // BI_BITFIELDS
+  put32(out, row_bytes * h);
+  put32(out, 2835);                 // 72 dpi
+  put32(out, 2835);
+  put32(out, 0);
+  put32(out, 0);
+  put32(out, 0xF800);               // red, green and blue masks
+  put32(out, 0x07E0);
+  put32(out, 0x001F);
+
+  for (int16_t j = 0; j < h; j++)
+  {
+    for (int16_t i = 0; i < w; i++)
+      put16(out, gfx->getPixel(x + i, y + j));
+    if (row_bytes > w * 2u)
+      put16(out, 0);                // pad odd widths
+  }
+}
+
+bool checkGolden(GigaDisplay_GFX *gfx, const char *name, int16_t x, int16_t y, uint16_t w, uint16_t h)
+{
+  MemoryPrint frame;
+  std::vector<uint8_t> golden;
+  char path[256];
+  int differ = 0;
+
+  frameBMP(gfx, x, y, w, h, &frame.bytes);
+  snprintf(path, sizeof(path), "%s/%s.bmp", GU_GOLDEN_DIR, name);
+
+  if (getenv("GU_UPDATE_GOLDEN") != NULL)
+  {
+    if (!writeFile(path, frame.bytes))
+    {
+      fprintf(stderr, "%s: can't write %s\n", name, path);
+      test_failures++;
+      return false;
+    }
+    printf("%s: golden image written\n", name);
+    return true;
+  }
+
+  if (!readFile(path, &golden))
+  {
+    fprintf(stderr, "%s: no golden image %s (set GU_UPDATE_GOLDEN to make it)\n", name, path);
+    test_failures++;
+    return false;
+  }
+  if (golden.size() != frame.bytes.size())
+  {
+    differ = -1;
+  }
+  else
+  {
+    // Count the pixels (pairs of bytes past the header) that differ.
+    for (size_t i = 0; i < golden.size(); i += 2)
+    {
+      if (golden[i] != frame.bytes[i] || golden[i + 1] != frame.bytes[i + 1])
+        differ++;
+    }
+  }
+  if (differ == 0)
+  {
+    printf("%s: matches\n", name);
+    return true;
+  }
+
+  snprintf(path, sizeof(path), "%s.bmp", name);
+  writeFile(path, frame.bytes);
+  if (differ < 0)
+    fprintf(stderr, "%s: golden image is a different size; frame written to %s\n", name, path);
+  else
+    fprintf(stderr, "%s: %d pixels differ from the golden image; frame written to %s\n", name, differ, path);
+  test_failures++;
+  return false;
+}
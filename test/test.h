@@ -0,0 +1,38 @@
+#ifndef GU_TEST_H
+#define GU_TEST_H
+
+// Support for the host tests: checks that count failures, and comparing
+// frames with golden images.
+
+#include <vector>
+#include "GU_Elements.h"
+
+extern int test_failures;
+
+#define CHECK(cond) \
+  do { if (!(cond)) { fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+                      test_failures++; } } while (0)
+
+// Return the exit status for main.
+int testResult(void);
+
+// A Print that keeps what is written to it.
+class MemoryPrint : public Print
+{
+public:
+  size_t write(uint8_t c) { bytes.push_back(c); return 1; }
+  using Print::write;
+
+  std::vector<uint8_t> bytes;
+};
+
+// Compare a rectangle of the screen with golden/<name>.bmp. If they differ,
+// the frame is written to <name>.bmp in the current directory to be looked
+// at. With GU_UPDATE_GOLDEN set in the environment, the golden image is
+// written instead. Return true if they match.
+bool checkGolden(GigaDisplay_GFX *gfx, const char *name, int16_t x, int16_t y, uint16_t w, uint16_t h);
+
+// Write bytes to a file. Return false if it can't be written.
+bool writeFile(const char *path, const std::vector<uint8_t> &bytes);
+
+#endif
@@ -0,0 +1,50 @@
+#include <vector>
+#include "test.h"
+
+// Display lists: what is drawn through a list is what would have been drawn
+// straight away, including text recorded as the command table fills up.
+
+GigaDisplay_GFX tft;
+FontCollection fc(&tft, NULL, NULL, 1, 1);
+
+// A screenful of one-character texts, enough to fill the command table,
+// then longer ones whose copies land where the bytes are reused.
+void drawTexts(void)
+{
+  GU_FrameBuffer fb(&tft);
+  int n = 0;
+
+  fb.fillRect(0, 0, tft.width(), tft.height(), BLACK);
+  for (int i = 0; i < GU_DISPLAY_LIST_SIZE; i++, n++)
+    fb.drawText(&fc, (char)('A' + i % 26), 10 + (n % 40) * 19, 20 + (n / 40) * 20, WHITE);
+  fb.drawText(&fc, "Marker", 10, 200, YELLOW);
+  for (int i = 0; i < 20; i++)
+    fb.drawText(&fc, "A much longer line of text", 10 + (i % 2) * 390, 230 + (i / 2) * 20, GREEN);
+}
+
+void test_full_table(void)
+{
+  std::vector<uint16_t> direct;
+  uint16_t *p = tft.getBuffer();
+  int differ = 0;
+
+  drawTexts();
+  direct.assign(p, p + tft.width() * tft.height());
+
+  tft.fillScreen(RED);
+  GU_DisplayList::begin(&tft);
+  drawTexts();
+  GU_DisplayList::end();
+
+  for (int i = 0; i < tft.width() * tft.height(); i++)
+    differ += p[i] != direct[i];
+  CHECK(differ == 0);
+}
+
+int main()
+{
+  tft.begin();
+  tft.setRotation(1);
+  test_full_table();
+  return testResult();
+}
@@ -0,0 +1,124 @@
+#include <type_traits>
+#include "test.h"
+
+// Golden-image tests. Buttons, a menu, a pager and a sidebar are drawn on
+// the stand-in display, and what they draw is compared with images made
+// by the baseline library, before any of its drawing was replaced (see
+// CMakeLists.txt), so they show the drawing is still the same pixel for
+// pixel. This file is built against the baseline too, with
+// GU_GOLDEN_BASELINE defined, so it only uses what the baseline has.
+// After a change meant to alter what is drawn, look at the frames written
+// for the failures, and if they are right, run again with GU_UPDATE_GOLDEN
+// set to replace the golden images.
+
+#ifndef GU_GOLDEN_BASELINE
+// Elements point into their own storage, so they must not be copied.
+static_assert(!std::is_copy_constructible<GU_Button>::value && !std::is_copy_assignable<GU_Button>::value,
+              "buttons can't be copied");
+static_assert(!std::is_copy_constructible<GU_Menu>::value && !std::is_copy_assignable<GU_Menu>::value,
+              "menus can't be copied");
+#endif
+
+GestureDetector detector;
+GigaDisplay_GFX tft;
+FontCollection fc(&tft, NULL, NULL, 1, 1);
+
+GU_Button button1(&fc, &detector);
+GU_Button button2(&fc, &detector);
+GU_Button button3(&fc, &detector);
+GU_Menu menu(&fc, &detector);
+char *items[4] = { "An item", "Another item", "A long item name", "Last" };
+
+int curr_page = -1;
+
+// Pager callback. Nothing is drawn on the pages; just note which is shown.
+void swipe_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
+{
+  curr_page = indx & 0xFF;
+}
+
+void menu_cb(EventType ev, int indx, void *param, int x, int y)
+{
+}
+
+void test_buttons(void)
+{
+  tft.fillScreen(BLACK);
+  button1.initButtonUL(20, 20, 150, 45, BLACK, YELLOW, BLACK, "Button", 1);
+  button2.initButtonUL(190, 20, 150, 45, WHITE, DKGREY, WHITE, "Menu", 1);
+  button3.initButtonUL(20, 85, 320, 70, WHITE, BLUE, WHITE, "Big", 2);
+  button1.drawButton();
+  button2.drawButton();
+  button3.drawButton();
+  checkGolden(&tft, "buttons", 0, 0, 360, 175);
+
+  // Changing the label and colors draws the button again.
+  button2.setText("Changed");
+  button2.setColor(GREEN, BLACK, GREEN);
+  checkGolden(&tft, "buttons-changed", 0, 0, 360, 175);
+
+  button1.destroyButton();
+  button2.destroyButton();
+  button3.destroyButton();
+}
+
+void test_menu(void)
+{
+  tft.fillScreen(BLACK);
+  button2.initButtonUL(240, 5, 150, 45, WHITE, DKGREY, WHITE, "Menu", 1);
+  button2.drawButton();
+  menu.initMenu(&button2, WHITE, DKGREY, GREY, WHITE, menu_cb, 3);
+  menu.setMenuItem(0, items[0], true, false, true);
+  menu.setMenuItem(1, items[1], false);
+  menu.setMenuItem(2, items[2], true, true);
+  menu.setMenuItem(3, items[3]);
+  menu.setTip("A tip for the menu");
+
+  // Tapping the button drops the menu down.
+  CHECK(detector.tap(300, 20));
+  CHECK(menu.isAnyMenuDisplayed());
+  checkGolden(&tft, "menu", 230, 0, 250, 240);
+
+  // Tapping outside it takes it down again.
+  CHECK(detector.tap(700, 400));
+  CHECK(!menu.isAnyMenuDisplayed());
+  menu.destroyMenu();
+}
+
+void test_pager(void)
+{
+  GU_Pager pager(&tft, &detector);
+
+  pager.initPager(3, 1, swipe_cb, NULL, BLACK);
+  checkGolden(&tft, "pager-dots", 300, 400, 200, 80);
+
+  CHECK(detector.swipe(400, 240, -200, 0));
+  CHECK(curr_page == 2);
+  checkGolden(&tft, "pager-dots-swiped", 300, 400, 200, 80);
+  pager.destroyPager();
+}
+
+void test_sidebar(void)
+{
+  GU_Sidebar sidebar(&tft, &detector);
+
+  sidebar.initSidebar(3, 1, 320, DKGREY, WHITE, swipe_cb, NULL, BLACK);
+  CHECK(detector.swipe(400, 240, 200, 0));
+  CHECK(curr_page == 0);
+  // A band across the sidebar, the edge of the main page and its indicator.
+  checkGolden(&tft, "sidebar", 0, 220, tft.width(), 40);
+  sidebar.destroyPager();
+}
+
+int main()
+{
+  tft.begin();
+  tft.setRotation(1);
+  detector.setRotation(1);
+
+  test_buttons();
+  test_menu();
+  test_pager();
+  test_sidebar();
+  return testResult();
+}
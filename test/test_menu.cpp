@@ -0,0 +1,112 @@
+#include "test.h"
+
+// Flicking a long menu: it keeps scrolling a step each frame, with nothing
+// waiting in the gesture callback, and stops when touched. A menu taken
+// down by its arena leaves no tap behind on its button.
+
+GestureDetector detector;
+GigaDisplay_GFX tft;
+FontCollection fc(&tft, NULL, NULL, 1, 1);
+
+GU_Button button(&fc, &detector);
+GU_Menu menu(&fc, &detector);
+char labels[40][12];
+
+void menu_cb(EventType ev, int indx, void *param, int x, int y)
+{
+}
+
+// A checksum of the screen, to see when the menu has moved.
+uint32_t screenSum(void)
+{
+  uint16_t *p = tft.getBuffer();
+  uint32_t sum = 0;
+
+  for (int i = 0; i < tft.width() * tft.height(); i++)
+    sum = sum * 31 + p[i];
+  return sum;
+}
+
+// Flick upwards in the scroll arrow column, at the menu's left.
+void flick(void)
+{
+  CHECK(detector.drag(250, 400, 0, -60, 4, 20));
+}
+
+void test_fling(void)
+{
+  unsigned long start;
+  uint32_t sum;
+  int moves = 0;
+  int frames = 0;
+
+  tft.fillScreen(BLACK);
+  button.initButtonUL(240, 5, 150, 45, WHITE, DKGREY, WHITE, "Menu", 1);
+  button.drawButton();
+  menu.initMenu(&button, WHITE, DKGREY, GREY, WHITE, menu_cb, 3);
+  for (int i = 0; i < 40; i++)
+  {
+    snprintf(labels[i], sizeof(labels[i]), "Item %d", i);
+    menu.setMenuItem(i, labels[i]);
+  }
+  CHECK(detector.tap(300, 20));
+  CHECK(menu.isAnyMenuDisplayed());
+
+  // The flick returns as soon as the drag is done, leaving the fling running.
+  start = millis();
+  flick();
+  CHECK(millis() - start < 100);
+  CHECK(GU_Frame::numAnimating() == 1);
+
+  // Each frame moves it on, until it slows to a stop.
+  sum = screenSum();
+  while (GU_Frame::numAnimating() > 0 && frames < 200)
+  {
+    hostAdvance(1000000 / GU_FRAME_RATE);
+    if (GU_Frame::tick())
+      frames++;
+    if (screenSum() != sum)
+    {
+      moves++;
+      sum = screenSum();
+    }
+  }
+  CHECK(GU_Frame::numAnimating() == 0);
+  CHECK(moves >= 3);
+  CHECK(frames > moves);
+  CHECK(menu.isAnyMenuDisplayed());
+
+  // Back up the list, then a touch stops it straight away.
+  CHECK(detector.drag(250, 200, 0, 60, 4, 20));
+  CHECK(GU_Frame::numAnimating() == 1);
+  hostAdvance(1000000 / GU_FRAME_RATE);
+  GU_Frame::tick();
+  CHECK(GU_Frame::numAnimating() == 1);
+  detector.tap(700, 400);
+  CHECK(GU_Frame::numAnimating() == 0);
+  menu.destroyMenu();
+}
+
+void test_arena_reset(void)
+{
+  GU_Arena arena(&detector);
+  GU_Menu *m = arena.newMenu(&fc);
+
+  CHECK(m != NULL);
+  m->initMenu(&button, WHITE, DKGREY, GREY, WHITE, menu_cb, 7);
+  m->setMenuItem(0, "Item");
+  CHECK(detector.isEventRegistered(7));
+  arena.reset();
+  CHECK(!detector.isEventRegistered(7));
+  CHECK(!detector.tap(300, 20));
+}
+
+int main()
+{
+  tft.begin();
+  tft.setRotation(1);
+  detector.setRotation(1);
+  test_fling();
+  test_arena_reset();
+  return testResult();
+}
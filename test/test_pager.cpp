@@ -0,0 +1,165 @@
+#include "test.h"
+
+// The pager's page cache: pages come back from it, and its memory is
+// given back when it is turned off or the pager goes. A sidebar slides on
+// over the main page and off again, leaving it where it was. The dots and
+// the cancel button work again after being hidden, and their events are
+// given back when the pager is destroyed.
+
+GestureDetector detector;
+GigaDisplay_GFX tft;
+
+int renders = 0;
+int entered = -1;
+
+void swipe_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
+{
+  entered = indx & 0xFF;
+}
+
+// Each page is a different color.
+void render_cb(int page, Adafruit_GFX *gfx, void *param)
+{
+  renders++;
+  gfx->fillRect(100, 100, 200, 100, page == 0 ? RED : page == 1 ? GREEN : BLUE);
+}
+
+void test_cache(void)
+{
+  GU_Pager pager(&tft, &detector);
+  uint32_t page_bytes = (uint32_t)tft.width() * tft.height() * 2;
+
+  pager.enableCache(3 * page_bytes, render_cb);
+  CHECK(pager.getRenderGFX() != NULL);
+  pager.initPager(3, 0, swipe_cb, NULL, BLACK);
+
+  // The next page is rendered ahead while idle, and restored when swiped to.
+  pager.idle();
+  CHECK(renders >= 1);
+  CHECK(detector.swipe(400, 240, -200, 0));
+  CHECK(pager.isPageRestored());
+  CHECK(tft.getPixel(150, 150) == GREEN);
+
+  // Too small a budget turns the cache off, and frees the render GFX.
+  pager.enableCache(page_bytes - 1);
+  CHECK(pager.getRenderGFX() == NULL);
+  CHECK(detector.swipe(400, 240, 200, 0));
+  CHECK(!pager.isPageRestored());
+
+  // Turned on again, then left for the destructor to free.
+  pager.enableCache(2 * page_bytes, render_cb);
+  CHECK(pager.getRenderGFX() != NULL);
+  pager.idle();
+  pager.destroyPager();
+}
+
+// The main page has red and green stripes where the sidebar comes on.
+void sidebar_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
+{
+  if ((indx & 0xFF) == 1)
+  {
+    tft.fillRect(0, 0, 100, tft.height(), RED);
+    tft.fillRect(100, 0, 100, tft.height(), GREEN);
+  }
+}
+
+// Pixels across the band, looked at between the frames of a slide.
+const int16_t sample_x[3] = { 20, 120, 175 };
+std::vector<std::vector<uint16_t>> samples;
+
+void sample_cb(unsigned long ms)
+{
+  std::vector<uint16_t> s;
+
+  for (int i = 0; i < 3; i++)
+    s.push_back(tft.getPixel(sample_x[i], 240));
+  if (samples.empty() || samples.back() != s)
+    samples.push_back(s);
+}
+
+// Each pixel in the band is either the main page's, where it was, or the
+// sidebar's.
+bool onlySidebarOrMain(void)
+{
+  const uint16_t main_color[3] = { RED, GREEN, GREEN };
+  const uint16_t side = DKGREY;
+
+  for (auto &s : samples)
+  {
+    for (int i = 0; i < 3; i++)
+    {
+      if (s[i] != main_color[i] && s[i] != side && s[i] != WHITE)
+        return false;
+    }
+  }
+  return true;
+}
+
+void test_sidebar_slide(void)
+{
+  GU_Sidebar sidebar(&tft, &detector);
+  const uint16_t side = DKGREY;
+  bool uncovered = false;
+
+  sidebar.setSlide(4, 20);
+  sidebar.initSidebar(2, 1, 200, DKGREY, WHITE, sidebar_cb, NULL, BLACK);
+  CHECK(tft.getPixel(120, 240) == GREEN);
+
+  // On: the main page stays put under the sidebar.
+  hostOnDelay = sample_cb;
+  CHECK(detector.swipe(400, 240, 200, 0));
+  hostOnDelay = NULL;
+  CHECK(samples.size() >= 3);
+  CHECK(onlySidebarOrMain());
+  CHECK(tft.getPixel(120, 240) == side);
+
+  // Off: the main page is put back as the sidebar goes.
+  samples.clear();
+  hostOnDelay = sample_cb;
+  CHECK(detector.swipe(400, 240, -200, 0));
+  hostOnDelay = NULL;
+  CHECK(onlySidebarOrMain());
+  for (auto &s : samples)
+    uncovered |= s[2] == GREEN && s[0] == side;
+  CHECK(uncovered);
+  CHECK(tft.getPixel(120, 240) == GREEN);
+  sidebar.destroyPager();
+}
+
+void test_slots_kept(void)
+{
+  GU_Pager pager(&tft, &detector);
+  GU_Sidebar sidebar(&tft, &detector);
+  int n_free = GU_Slots::numFree();
+
+  // Hide the dots and show them again; tapping the third dot still works.
+  pager.initPager(3, 0, swipe_cb, NULL, BLACK);
+  pager.clearPage(false);
+  pager.clearPage(true);
+  CHECK(detector.tap(416, 448));
+  CHECK(entered == 2);
+  pager.destroyPager();
+  CHECK(GU_Slots::numFree() == n_free);
+
+  // The same for the sidebar's cancel button.
+  sidebar.initSidebar(2, 1, 200, DKGREY, WHITE, swipe_cb, NULL, BLACK);
+  CHECK(detector.swipe(400, 240, 200, 0));
+  CHECK(entered == 0);
+  sidebar.clearPage(false);
+  sidebar.clearPage(true);
+  CHECK(detector.tap(600, 240));
+  CHECK(entered == 1);
+  sidebar.destroyPager();
+  CHECK(GU_Slots::numFree() == n_free);
+}
+
+int main()
+{
+  tft.begin();
+  tft.setRotation(1);
+  detector.setRotation(1);
+  test_cache();
+  test_sidebar_slide();
+  test_slots_kept();
+  return testResult();
+}
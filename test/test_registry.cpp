@@ -0,0 +1,90 @@
+#include <new>
+#include "test.h"
+
+// Taps routed through a registry: to the areas in it, and past it to the
+// events below it in GestureDetector.
+
+GestureDetector detector;
+GU_Registry registry(&detector);
+
+int last_area = -1;
+int lower_taps = 0;
+
+void area_cb(EventType ev, int indx, void *param, int x, int y)
+{
+  if (ev & EV_RELEASED)
+    last_area = indx;
+}
+
+void lower_cb(EventType ev, int indx, void *param, int x, int y)
+{
+  if (ev & EV_RELEASED)
+    lower_taps++;
+}
+
+void test_routing(void)
+{
+  detector.onTap(0, 0, 0, 0, lower_cb, 2, NULL);
+  registry.initRegistry(5);
+
+  // Nothing registered: the registry takes no taps.
+  CHECK(detector.tap(100, 100));
+  CHECK(lower_taps == 1);
+
+  registry.onTap(10, 10, 100, 50, area_cb, 0, NULL);
+  registry.onTap(200, 10, 100, 50, area_cb, 1, NULL);
+  CHECK(registry.hitTest(250, 30) == 1);
+  CHECK(detector.tap(250, 30));
+  CHECK(last_area == 1);
+  CHECK(detector.tap(50, 30));
+  CHECK(last_area == 0);
+
+  // Outside the areas' extent, taps go on down.
+  CHECK(detector.tap(50, 300));
+  CHECK(lower_taps == 2);
+
+  // Between the areas, they are shadowed.
+  last_area = -1;
+  CHECK(detector.tap(150, 30));
+  CHECK(last_area == -1 && lower_taps == 2);
+
+  // Cancelling an area shrinks the extent.
+  registry.cancelEvent(1);
+  CHECK(detector.tap(150, 30));
+  CHECK(lower_taps == 3);
+
+  // A catch-all area takes everything.
+  registry.onTap(0, 0, 0, 0, area_cb, 3, NULL);
+  CHECK(detector.tap(50, 300));
+  CHECK(last_area == 3 && lower_taps == 3);
+  registry.cancelEvent(3);
+  CHECK(detector.tap(50, 300));
+  CHECK(lower_taps == 4);
+
+  registry.destroyRegistry();
+  CHECK(!detector.isEventRegistered(5));
+  CHECK(detector.tap(50, 30));
+  CHECK(lower_taps == 5);
+}
+
+// A registry anywhere but in zeroed memory starts out empty too.
+void test_not_zeroed(void)
+{
+  alignas(GU_Registry) uint8_t mem[sizeof(GU_Registry)];
+  GU_Registry *reg;
+
+  memset(mem, 0xA5, sizeof(mem));
+  reg = new (mem) GU_Registry(&detector);
+  CHECK(reg->hitTest(50, 30) == -1);
+  CHECK(!reg->isEventRegistered(0));
+  CHECK(reg->onTap(10, 10, 100, 50, area_cb, 0, NULL));
+  CHECK(reg->hitTest(50, 30) == 0);
+  reg->~GU_Registry();
+}
+
+int main()
+{
+  test_routing();
+  test_not_zeroed();
+  return testResult();
+}
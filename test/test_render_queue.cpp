@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "test.h"
+
+// The render queue under load: this thread posts redraws as fast as it can
+// while the render thread (GU_RenderQueue::startThread) makes them. Every
+// change must arrive once and in order. The throughput and the time from
+// posting to running (in real time) are printed.
+
+#define N_CHANGES   100000
+
+typedef std::chrono::steady_clock Clock;
+
+Clock::time_point posted[N_CHANGES];
+uint32_t latency_ns[N_CHANGES];
+std::atomic<uint32_t> n_run(0);
+uint32_t out_of_order = 0;
+
+// The element is the change's sequence number.
+void run_cb(void *element)
+{
+  uint32_t seq = (uint32_t)(uintptr_t)element;
+  uint32_t n = n_run.load(std::memory_order_relaxed);
+
+  if (seq != n)
+    out_of_order++;
+  if (seq < N_CHANGES)
+    latency_ns[seq] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - posted[seq]).count();
+  n_run.store(n + 1, std::memory_order_relaxed);
+}
+
+void producer(void)
+{
+  for (uint32_t seq = 0; seq < N_CHANGES; )
+  {
+    posted[seq] = Clock::now();
+    if (GU_RenderQueue::redraw((void *)(uintptr_t)seq, run_cb))
+      seq++;
+    else
+      std::this_thread::yield();    // full; the consumer may need the CPU
+  }
+}
+
+void test_stress(void)
+{
+  Clock::time_point start;
+  double secs;
+
+  CHECK(GU_RenderQueue::startThread());
+  start = Clock::now();
+  producer();
+  while (n_run.load(std::memory_order_relaxed) < N_CHANGES
+         && Clock::now() - start < std::chrono::seconds(10))
+    std::this_thread::yield();
+  secs = std::chrono::duration<double>(Clock::now() - start).count();
+  GU_RenderQueue::stopThread();
+
+  CHECK(n_run.load() == N_CHANGES);
+  CHECK(out_of_order == 0);
+  CHECK(GU_RenderQueue::numWaiting() == 0);
+  CHECK(GU_RenderQueue::numPosted() == N_CHANGES);
+
+  std::sort(latency_ns, latency_ns + N_CHANGES);
+  printf("%d changes in %.3fs (%.0f/s), %u full\n", N_CHANGES, secs, N_CHANGES / secs,
+         (unsigned)GU_RenderQueue::numDropped());
+  printf("latency us: median %.1f, 99%% %.1f, max %.1f\n", latency_ns[N_CHANGES / 2] / 1000.0,
+         latency_ns[N_CHANGES * 99 / 100] / 1000.0, latency_ns[N_CHANGES - 1] / 1000.0);
+}
+
+int main()
+{
+  test_stress();
+  return testResult();
+}
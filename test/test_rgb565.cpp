@@ -0,0 +1,95 @@
+#include "test.h"
+
+// The span functions: each gives what its one-pixel function gives, pixel
+// for pixel, whatever the alignment and length of the span, and leaves the
+// pixels either side of it alone.
+
+#define N 64
+
+uint16_t dst[N + 2];
+uint16_t src[N + 2];
+uint16_t expect[N + 2];
+
+// Fill the buffers with colors that exercise every bit of every field.
+void fill(void)
+{
+  for (int i = 0; i < N + 2; i++)
+  {
+    dst[i] = expect[i] = i * 7919 + 0x1234;
+    src[i] = i * 104729 + 0x8421;
+  }
+}
+
+bool matches(void)
+{
+  for (int i = 0; i < N + 2; i++)
+    if (dst[i] != expect[i])
+      return false;
+  return true;
+}
+
+void test_average(void)
+{
+  for (int d = 0; d < 2; d++)
+    for (int s = 0; s < 2; s++)
+      for (int n = 0; n < N; n++)
+      {
+        fill();
+        for (int i = 0; i < n; i++)
+          expect[d + i] = rgb565_average(expect[d + i], src[s + i]);
+        rgb565_average_span(dst + d, src + s, n);
+        CHECK(matches());
+      }
+}
+
+void test_blend(void)
+{
+  for (int alpha = 0; alpha <= RGB565_ALPHA_MAX; alpha++)
+    for (int d = 0; d < 2; d++)
+      for (int s = 0; s < 2; s++)
+        for (int n = 0; n < N; n += 3)
+        {
+          fill();
+          for (int i = 0; i < n; i++)
+            expect[d + i] = rgb565_blend(src[s + i], expect[d + i], alpha);
+          rgb565_blend_span(dst + d, src + s, n, alpha);
+          CHECK(matches());
+        }
+}
+
+void test_mix(void)
+{
+  for (int alpha = 0; alpha <= RGB565_ALPHA_MAX; alpha++)
+    for (int d = 0; d < 2; d++)
+      for (int n = 0; n < N; n += 3)
+      {
+        fill();
+        for (int i = 0; i < n; i++)
+          expect[d + i] = rgb565_blend(0xA5C3, expect[d + i], alpha);
+        rgb565_mix_span(dst + d, n, 0xA5C3, alpha);
+        CHECK(matches());
+      }
+}
+
+void test_darken(void)
+{
+  for (int amount = 0; amount <= RGB565_ALPHA_MAX; amount++)
+    for (int d = 0; d < 2; d++)
+      for (int n = 0; n < N; n += 3)
+      {
+        fill();
+        for (int i = 0; i < n; i++)
+          expect[d + i] = rgb565_blend(BLACK, expect[d + i], amount);
+        rgb565_darken_span(dst + d, n, amount);
+        CHECK(matches());
+      }
+}
+
+int main()
+{
+  test_average();
+  test_blend();
+  test_mix();
+  test_darken();
+  return testResult();
+}
@@ -0,0 +1,105 @@
+#include "test.h"
+
+// Pixel counts: text drawn through a display list is counted the same as
+// text drawn straight away, against the element that drew it. The heatmap
+// of the last frame is written to stats-heatmap.bmp.
+
+GigaDisplay_GFX tft;
+FontCollection fc(&tft, NULL, NULL, 1, 1);
+
+int outer, inner;
+
+void test_replayed_text(void)
+{
+  uint32_t direct;
+
+  CHECK(GU_Stats::begin(&tft));
+  GU_Stats::nextFrame();
+  {
+    GU_FrameBuffer fb(&tft);
+
+    GU_Stats::setWidget(&inner, GU_STATS_KEYBOARD);
+    fb.drawText(&fc, "Counted text", 100, 100, WHITE, 2);
+  }
+  direct = GU_Stats::frameWrites();
+  CHECK(direct > 0);
+  CHECK(GU_Stats::kindWrites(GU_STATS_KEYBOARD) == direct);
+
+  GU_Stats::nextFrame();
+  GU_DisplayList::begin(&tft);
+  {
+    GU_FrameBuffer fb(&tft);
+
+    GU_Stats::setWidget(&inner, GU_STATS_KEYBOARD);
+    fb.drawText(&fc, "Counted text", 100, 100, WHITE, 2);
+  }
+  GU_Stats::setWidget(&outer, GU_STATS_MENU);
+  GU_DisplayList::end();
+
+  // The replay counts the text against its element, then puts back the
+  // element that was drawing.
+  CHECK(GU_Stats::frameWrites() == direct);
+  CHECK(GU_Stats::kindWrites(GU_STATS_KEYBOARD) == 2 * direct);
+  CHECK(GU_Stats::kindWrites(GU_STATS_MENU) == 0);
+  CHECK(GU_Stats::getWidget() == &outer);
+  CHECK(GU_Stats::getKind() == GU_STATS_MENU);
+
+  MemoryPrint heatmap;
+
+  GU_Stats::dumpHeatmap(&heatmap);
+  CHECK(heatmap.bytes.size() > 54);
+  CHECK(writeFile("stats-heatmap.bmp", heatmap.bytes));
+  GU_Stats::end();
+}
+
+// Find what an element has written since begin.
+uint32_t widgetWrites(void *element, GU_StatsKind *kind)
+{
+  for (int i = 0; i < GU_Stats::numWidgets(); i++)
+  {
+    void *widget;
+    uint32_t writes;
+
+    GU_Stats::getWidget(i, &widget, kind, &writes);
+    if (widget == element)
+      return writes;
+  }
+  return 0;
+}
+
+void pager_cb(EventType ev, int indx, void *param, int x, int y, int dx, int dy)
+{
+}
+
+// A basic pager's clears and slides are counted against it.
+void test_pager(void)
+{
+  GestureDetector detector;
+  GU_BasicPager pager(&tft, &detector);
+  uint32_t screen = (uint32_t)tft.width() * tft.height();
+  GU_StatsKind kind;
+
+  CHECK(GU_Stats::begin(&tft, false));
+  GU_Stats::setWidget(&outer, GU_STATS_MENU);
+  pager.initPager(2, 0, pager_cb);
+  CHECK(widgetWrites(&pager, &kind) == screen);
+  CHECK(kind == GU_STATS_PAGER);
+
+  // Each frame of the slide moves the screen along and fills the strip
+  // uncovered (a screenful between them), then the page is cleared.
+  pager.setSlide(4);
+  pager.gotoPage(1);
+  CHECK(widgetWrites(&pager, &kind) == 6 * screen);
+  CHECK(GU_Stats::kindWrites(GU_STATS_MENU) == 0);
+  pager.destroyPager();
+  GU_Stats::end();
+}
+
+int main()
+{
+  tft.begin();
+  tft.setRotation(1);
+  test_replayed_text();
+  test_pager();
+  return testResult();
+}
@@ -0,0 +1,81 @@
+#include "test.h"
+
+// Gesture traces: taps through a registry are recorded and replayed to the
+// same areas, and events for elements that are gone are rejected.
+
+GestureDetector detector;
+GU_Registry registry(&detector);
+
+int hits = 0;
+
+void area_cb(EventType ev, int indx, void *param, int x, int y)
+{
+  if (ev & EV_RELEASED)
+    hits += indx + 1;
+}
+
+void test_replay(void)
+{
+  uint8_t trace[256];
+  uint32_t len;
+  GU_TraceResult result;
+
+  registry.initRegistry(5);
+  registry.onTap(10, 10, 100, 50, area_cb, 0, NULL);
+  registry.onTap(200, 10, 100, 50, area_cb, 1, NULL);
+
+  GU_Trace::record(trace, sizeof(trace));
+  detector.tap(50, 30);
+  detector.tap(250, 30);
+  detector.tap(50, 30);
+  len = GU_Trace::stop();
+  CHECK(len == 4 + 6 * GU_TRACE_EVENT_SIZE);
+  CHECK(hits == 4);
+
+  hits = 0;
+  CHECK(GU_Trace::replay(trace, len, &result));
+  CHECK(result.events == 6 && result.rejected == 0);
+  CHECK(hits == 4);
+
+  // Ids out of range, or with no element, are rejected.
+  trace[4 + 14] = GU_TRACE_ELEMENTS;
+  trace[4 + 15] = 0;
+  trace[4 + GU_TRACE_EVENT_SIZE + 14] = GU_TRACE_ELEMENTS - 1;
+  trace[4 + GU_TRACE_EVENT_SIZE + 15] = 0;
+  hits = 0;
+  CHECK(GU_Trace::replay(trace, len, &result));
+  CHECK(result.events == 4 && result.rejected == 2);
+  CHECK(hits == 3);
+}
+
+// A registry that has gone takes its id with it.
+void test_gone(void)
+{
+  uint8_t trace[256];
+  uint32_t len;
+  GU_TraceResult result;
+
+  registry.destroyRegistry();
+  {
+    GU_Registry local(&detector);
+
+    local.initRegistry(6);
+    local.onTap(10, 10, 100, 50, area_cb, 0, NULL);
+    GU_Trace::record(trace, sizeof(trace));
+    detector.tap(50, 30);
+    len = GU_Trace::stop();
+    local.destroyRegistry();
+  }
+
+  hits = 0;
+  CHECK(GU_Trace::replay(trace, len, &result));
+  CHECK(result.events == 0 && result.rejected == 2);
+  CHECK(hits == 0);
+}
+
+int main()
+{
+  test_replay();
+  test_gone();
+  return testResult();
+}